@@ -10,7 +10,7 @@
 // This file defines the 'Statistic' class, which is designed to be an easy way
 // to expose various metrics from passes.  These statistics are printed at the
 // end of a run (from llvm_shutdown), when the -stats command line option is
-// passed on the command line.
+// passed on the command line.  With -stats-json they are printed as JSON.
 //
 // This is useful for reporting information like the number of instructions
 // simplified, optimized or removed by various transformations, like this:
@@ -26,8 +26,8 @@
 #ifndef LLVM_ADT_STATISTIC_H
 #define LLVM_ADT_STATISTIC_H
 
-#include "llvm/Support/Atomic.h"
-#include "llvm/Support/Valgrind.h"
+#include "llvm/Support/Compiler.h"
+#include <atomic>
 
 namespace llvm {
 class raw_ostream;
@@ -36,75 +36,78 @@ class Statistic {
 public:
   const char *Name;
   const char *Desc;
-  volatile llvm::sys::cas_flag Value;
-  bool Initialized;
+  std::atomic<unsigned> Value;
+  std::atomic<bool> Initialized;
 
-  llvm::sys::cas_flag getValue() const { return Value; }
+  unsigned getValue() const { return Value.load(std::memory_order_relaxed); }
   const char *getName() const { return Name; }
   const char *getDesc() const { return Desc; }
 
   /// construct - This should only be called for non-global statistics.
   void construct(const char *name, const char *desc) {
     Name = name; Desc = desc;
-    Value = 0; Initialized = false;
+    Value.store(0, std::memory_order_relaxed);
+    Initialized.store(false, std::memory_order_relaxed);
   }
 
   // Allow use of this class as the value itself.
-  operator unsigned() const { return Value; }
+  operator unsigned() const { return getValue(); }
 
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
-   const Statistic &operator=(unsigned Val) {
-    Value = Val;
+  // Counters are only ever summed and read once everything is done, so the
+  // updates need atomicity but no ordering.
+  const Statistic &operator=(unsigned Val) {
+    Value.store(Val, std::memory_order_relaxed);
     return init();
   }
 
   const Statistic &operator++() {
-    // FIXME: This function and all those that follow carefully use an
-    // atomic operation to update the value safely in the presence of
-    // concurrent accesses, but not to read the return value, so the
-    // return value is not thread safe.
-    sys::AtomicIncrement(&Value);
+    Value.fetch_add(1, std::memory_order_relaxed);
     return init();
   }
 
+  // The postfix forms return the value observed by the atomic update itself,
+  // so concurrent updates from several threads each see a distinct result.
   unsigned operator++(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicIncrement(&Value);
-    return OldValue;
+    return Value.fetch_add(1, std::memory_order_relaxed);
   }
 
   const Statistic &operator--() {
-    sys::AtomicDecrement(&Value);
+    Value.fetch_sub(1, std::memory_order_relaxed);
     return init();
   }
 
   unsigned operator--(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicDecrement(&Value);
-    return OldValue;
+    return Value.fetch_sub(1, std::memory_order_relaxed);
   }
 
   const Statistic &operator+=(const unsigned &V) {
     if (!V) return *this;
-    sys::AtomicAdd(&Value, V);
+    Value.fetch_add(V, std::memory_order_relaxed);
     return init();
   }
 
   const Statistic &operator-=(const unsigned &V) {
     if (!V) return *this;
-    sys::AtomicAdd(&Value, -V);
+    Value.fetch_sub(V, std::memory_order_relaxed);
     return init();
   }
 
   const Statistic &operator*=(const unsigned &V) {
-    sys::AtomicMul(&Value, V);
+    unsigned Old = Value.load(std::memory_order_relaxed);
+    while (!Value.compare_exchange_weak(Old, Old * V,
+                                        std::memory_order_relaxed))
+      ;
     return init();
   }
 
   const Statistic &operator/=(const unsigned &V) {
-    sys::AtomicDiv(&Value, V);
+    unsigned Old = Value.load(std::memory_order_relaxed);
+    while (!Value.compare_exchange_weak(Old, Old / V,
+                                        std::memory_order_relaxed))
+      ;
     return init();
   }
 
@@ -150,10 +153,10 @@ public:
 
 protected:
   Statistic &init() {
-    bool tmp = Initialized;
-    sys::MemoryFence();
-    if (!tmp) RegisterStatistic();
-    TsanHappensAfter(this);
+    // Registration publishes the statistic with a release store, so once it
+    // is seen here no further synchronization is needed.
+    if (LLVM_UNLIKELY(!Initialized.load(std::memory_order_acquire)))
+      RegisterStatistic();
     return *this;
   }
   void RegisterStatistic();
@@ -162,11 +165,15 @@ protected:
 // STATISTIC - A macro to make definition of statistics really simple.  This
 // automatically passes the DEBUG_TYPE of the file into the statistic.
 #define STATISTIC(VARNAME, DESC) \
-  static llvm::Statistic VARNAME = { DEBUG_TYPE, DESC, 0, 0 }
+  static llvm::Statistic VARNAME = { DEBUG_TYPE, DESC, {0}, {false} }
 
 /// \brief Enable the collection and printing of statistics.
 void EnableStatistics();
 
+/// \brief Undo EnableStatistics(). Statistics bumped while they were enabled
+/// stay registered, but are no longer printed on exit.
+void DisableStatistics();
+
 /// \brief Check if statistics are enabled.
 bool AreStatisticsEnabled();
 
@@ -176,6 +183,10 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print statistics to the given output stream as a JSON array with
+/// one object per statistic, holding its type, description and value.
+void PrintStatisticsJSON(raw_ostream &OS);
+
 } // End llvm namespace
 
 #endif
@@ -0,0 +1,468 @@
+//===- llvm/ADT/SwissMap.h - Group probed hash table ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SwissMap class, an open addressing hash table that
+// keeps one control byte per bucket and probes groups of buckets at a time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_SWISSMAP_H
+#define LLVM_ADT_SWISSMAP_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LLVM_SWISSMAP_SSE2 1
+#endif
+
+namespace llvm {
+
+namespace detail {
+/// The control bytes of a group of consecutive buckets. A control byte is
+/// CtrlEmpty, CtrlDeleted, or the 7 high bits of the hash of the key in a full
+/// bucket, so that the buckets whose key may match can be found without
+/// touching the keys. With SSE2 a whole group is compared in one instruction.
+class SwissMapGroup {
+public:
+  enum { Width = 16 };
+  enum { CtrlEmpty = -128, CtrlDeleted = -2 };
+
+  explicit SwissMapGroup(const int8_t *Ctrl)
+#ifdef LLVM_SWISSMAP_SSE2
+      : Ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Ctrl))) {
+  }
+#else
+      : Ctrl(Ctrl) {
+  }
+#endif
+
+  static bool isFull(int8_t C) { return C >= 0; }
+
+  /// Return a mask with one bit set for every bucket whose control byte is H2.
+  unsigned match(int8_t H2) const {
+#ifdef LLVM_SWISSMAP_SSE2
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(Ctrl, _mm_set1_epi8(H2)));
+#else
+    return matchIf([H2](int8_t C) { return C == H2; });
+#endif
+  }
+
+  /// Return a mask with one bit set for every empty bucket.
+  unsigned matchEmpty() const {
+#ifdef LLVM_SWISSMAP_SSE2
+    return _mm_movemask_epi8(
+        _mm_cmpeq_epi8(Ctrl, _mm_set1_epi8(int8_t(CtrlEmpty))));
+#else
+    return matchIf([](int8_t C) { return C == CtrlEmpty; });
+#endif
+  }
+
+  /// Return a mask with one bit set for every empty or deleted bucket.
+  unsigned matchEmptyOrDeleted() const {
+#ifdef LLVM_SWISSMAP_SSE2
+    // Both special values are below -1, full buckets are not negative.
+    return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), Ctrl));
+#else
+    return matchIf([](int8_t C) { return C < -1; });
+#endif
+  }
+
+private:
+#ifdef LLVM_SWISSMAP_SSE2
+  __m128i Ctrl;
+#else
+  const int8_t *Ctrl;
+
+  template <typename PredT> unsigned matchIf(PredT Pred) const {
+    unsigned Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      if (Pred(Ctrl[I]))
+        Mask |= 1u << I;
+    return Mask;
+  }
+#endif
+};
+} // end namespace detail
+
+/// SwissMap - A hash map with the interface of DenseMap, but organized like
+/// the "Swiss table": next to the buckets there is an array of control bytes,
+/// and lookups compare the 7 hash bits stored there for a whole group of
+/// buckets at once, only looking at keys whose hash bits match. Probing moves
+/// from group to group, so even at a high load factor a lookup typically reads
+/// one cache line of control bytes and one key.
+///
+/// Unlike DenseMap, keys do not need reserved empty and tombstone values, as
+/// that state is kept in the control bytes. KeyInfoT only has to provide
+/// getHashValue and isEqual. The hash is remixed, so weak hashes like the one
+/// DenseMapInfo uses for pointers are fine.
+///
+/// As with DenseMap, inserting invalidates iterators and references to
+/// elements, while erasing only invalidates those to the erased element.
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>>
+class SwissMap {
+  typedef detail::SwissMapGroup Group;
+
+public:
+  typedef unsigned size_type;
+  typedef KeyT key_type;
+  typedef ValueT mapped_type;
+  typedef detail::DenseMapPair<KeyT, ValueT> value_type;
+
+private:
+  typedef value_type BucketT;
+
+  template <bool IsConst> class IteratorImpl {
+    friend class SwissMap;
+    friend class IteratorImpl<!IsConst>;
+
+  public:
+    typedef ptrdiff_t difference_type;
+    typedef typename std::conditional<IsConst, const BucketT, BucketT>::type
+        value_type;
+    typedef value_type *pointer;
+    typedef value_type &reference;
+    typedef std::forward_iterator_tag iterator_category;
+
+  private:
+    const int8_t *Ctrl, *CtrlEnd;
+    pointer Ptr;
+
+    IteratorImpl(const int8_t *Ctrl, const int8_t *CtrlEnd, pointer Ptr)
+        : Ctrl(Ctrl), CtrlEnd(CtrlEnd), Ptr(Ptr) {}
+
+    void advancePastUnused() {
+      while (Ctrl != CtrlEnd && !Group::isFull(*Ctrl)) {
+        ++Ctrl;
+        ++Ptr;
+      }
+    }
+
+  public:
+    IteratorImpl() : Ctrl(nullptr), CtrlEnd(nullptr), Ptr(nullptr) {}
+
+    // Allow conversion from iterator to const_iterator.
+    template <bool IsConstSrc,
+              typename = typename std::enable_if<!IsConstSrc && IsConst>::type>
+    IteratorImpl(const IteratorImpl<IsConstSrc> &I)
+        : Ctrl(I.Ctrl), CtrlEnd(I.CtrlEnd), Ptr(I.Ptr) {}
+
+    reference operator*() const { return *Ptr; }
+    pointer operator->() const { return Ptr; }
+
+    bool operator==(const IteratorImpl &RHS) const { return Ctrl == RHS.Ctrl; }
+    bool operator!=(const IteratorImpl &RHS) const { return Ctrl != RHS.Ctrl; }
+
+    IteratorImpl &operator++() {
+      ++Ctrl;
+      ++Ptr;
+      advancePastUnused();
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      IteratorImpl Tmp = *this;
+      ++*this;
+      return Tmp;
+    }
+  };
+
+public:
+  typedef IteratorImpl<false> iterator;
+  typedef IteratorImpl<true> const_iterator;
+
+  explicit SwissMap(unsigned InitialReserve = 0) { reserve(InitialReserve); }
+
+  SwissMap(const SwissMap &Other) {
+    if (!Other.NumBuckets)
+      return;
+    allocateBuckets(Other.NumBuckets);
+    std::memcpy(Ctrl, Other.Ctrl, NumBuckets);
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Group::isFull(Ctrl[I]))
+        new (&Buckets[I]) BucketT(Other.Buckets[I]);
+    NumEntries = Other.NumEntries;
+    GrowthLeft = Other.GrowthLeft;
+  }
+
+  SwissMap(SwissMap &&Other) { swap(Other); }
+
+  SwissMap &operator=(SwissMap Other) {
+    swap(Other);
+    return *this;
+  }
+
+  ~SwissMap() {
+    destroyAll();
+    deallocateBuckets(Ctrl, Buckets);
+  }
+
+  void swap(SwissMap &RHS) {
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(NumBuckets, RHS.NumBuckets);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(GrowthLeft, RHS.GrowthLeft);
+  }
+
+  iterator begin() { return makeIterator(0, /*Advance=*/true); }
+  iterator end() { return makeIterator(NumBuckets, /*Advance=*/false); }
+  const_iterator begin() const { return makeIterator(0, /*Advance=*/true); }
+  const_iterator end() const {
+    return makeIterator(NumBuckets, /*Advance=*/false);
+  }
+
+  bool LLVM_ATTRIBUTE_UNUSED_RESULT empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the map so that it can hold NumEntries elements without rehashing.
+  void reserve(size_type NumEntries) {
+    if (NumEntries <= getMaxLoad(NumBuckets))
+      return;
+    unsigned NewNumBuckets = Group::Width;
+    while (getMaxLoad(NewNumBuckets) < NumEntries)
+      NewNumBuckets *= 2;
+    rehash(NewNumBuckets);
+  }
+
+  void clear() {
+    if (NumEntries == 0 && GrowthLeft == getMaxLoad(NumBuckets))
+      return;
+    destroyAll();
+    std::memset(Ctrl, Group::CtrlEmpty, NumBuckets);
+    NumEntries = 0;
+    GrowthLeft = getMaxLoad(NumBuckets);
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const KeyT &Key) const { return findBucket(Key) ? 1 : 0; }
+
+  iterator find(const KeyT &Key) {
+    if (const BucketT *B = findBucket(Key))
+      return makeIterator(B - Buckets, /*Advance=*/false);
+    return end();
+  }
+  const_iterator find(const KeyT &Key) const {
+    if (const BucketT *B = findBucket(Key))
+      return makeIterator(B - Buckets, /*Advance=*/false);
+    return end();
+  }
+
+  /// Return the entry for the specified key, or a default constructed value
+  /// if no such entry exists.
+  ValueT lookup(const KeyT &Key) const {
+    if (const BucketT *B = findBucket(Key))
+      return B->getSecond();
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    return insertImpl(KV.first, KV.second);
+  }
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    return insertImpl(std::move(KV.first), std::move(KV.second));
+  }
+
+  ValueT &operator[](const KeyT &Key) {
+    return insertImpl(Key).first->getSecond();
+  }
+  ValueT &operator[](KeyT &&Key) {
+    return insertImpl(std::move(Key)).first->getSecond();
+  }
+
+  bool erase(const KeyT &Key) {
+    const BucketT *B = findBucket(Key);
+    if (!B)
+      return false;
+    eraseBucket(B - Buckets);
+    return true;
+  }
+  void erase(iterator I) { eraseBucket(I.Ptr - Buckets); }
+
+private:
+  int8_t *Ctrl = nullptr;
+  BucketT *Buckets = nullptr;
+  unsigned NumBuckets = 0;
+  unsigned NumEntries = 0;
+  /// Number of empty buckets that can still be filled before the table has
+  /// to be rehashed. Deleted buckets do not count as empty.
+  unsigned GrowthLeft = 0;
+
+  /// Keep the load factor, including deleted buckets, at or below 7/8. This
+  /// guarantees that every probe sequence ends in a group with an empty
+  /// bucket.
+  static unsigned getMaxLoad(unsigned NumBuckets) {
+    return NumBuckets - NumBuckets / 8;
+  }
+
+  static uint64_t getHash(const KeyT &Key) {
+    // Spread the hash over all 64 bits. The top 7 bits become the control
+    // byte and the bits below them select the first group to probe.
+    return uint64_t(KeyInfoT::getHashValue(Key)) * 0x9E3779B97F4A7C15ULL;
+  }
+  static int8_t getH2(uint64_t Hash) { return int8_t(Hash >> 57); }
+  unsigned getFirstGroup(uint64_t Hash) const {
+    return unsigned(Hash >> 25) & (NumBuckets / Group::Width - 1);
+  }
+  unsigned getNextGroup(unsigned G, unsigned Stride) const {
+    // Triangular probing visits every group of a power of two sized table.
+    return (G + Stride) & (NumBuckets / Group::Width - 1);
+  }
+
+  iterator makeIterator(unsigned Idx, bool Advance) {
+    iterator I(Ctrl + Idx, Ctrl + NumBuckets, Buckets + Idx);
+    if (Advance)
+      I.advancePastUnused();
+    return I;
+  }
+  const_iterator makeIterator(unsigned Idx, bool Advance) const {
+    const_iterator I(Ctrl + Idx, Ctrl + NumBuckets, Buckets + Idx);
+    if (Advance)
+      I.advancePastUnused();
+    return I;
+  }
+
+  const BucketT *findBucket(const KeyT &Key) const {
+    return NumBuckets ? findBucket(Key, getHash(Key)) : nullptr;
+  }
+  BucketT *findBucket(const KeyT &Key, uint64_t Hash) const {
+    int8_t H2 = getH2(Hash);
+    unsigned G = getFirstGroup(Hash);
+    for (unsigned Stride = 1;; ++Stride) {
+      const int8_t *GroupCtrl = Ctrl + G * Group::Width;
+      Group Grp(GroupCtrl);
+      for (unsigned Mask = Grp.match(H2); Mask; Mask &= Mask - 1) {
+        unsigned Idx = G * Group::Width + countTrailingZeros(Mask);
+        if (LLVM_LIKELY(KeyInfoT::isEqual(Key, Buckets[Idx].getFirst())))
+          return Buckets + Idx;
+      }
+      if (LLVM_LIKELY(Grp.matchEmpty()))
+        return nullptr;
+      G = getNextGroup(G, Stride);
+    }
+  }
+
+  /// Return the index of the first empty or deleted bucket in the probe
+  /// sequence of Hash.
+  unsigned findInsertSlot(uint64_t Hash) const {
+    unsigned G = getFirstGroup(Hash);
+    for (unsigned Stride = 1;; ++Stride) {
+      Group Grp(Ctrl + G * Group::Width);
+      if (unsigned Mask = Grp.matchEmptyOrDeleted())
+        return G * Group::Width + countTrailingZeros(Mask);
+      G = getNextGroup(G, Stride);
+    }
+  }
+
+  template <typename KeyArgT, typename... ValueArgTs>
+  std::pair<iterator, bool> insertImpl(KeyArgT &&Key, ValueArgTs &&... Values) {
+    uint64_t Hash = getHash(Key);
+    if (NumBuckets)
+      if (BucketT *B = findBucket(Key, Hash))
+        return std::make_pair(makeIterator(B - Buckets, /*Advance=*/false),
+                              false);
+
+    if (GrowthLeft == 0) {
+      // Rehash in place to drop the deleted buckets if that frees enough
+      // room, otherwise double the table.
+      if (NumBuckets && NumEntries < getMaxLoad(NumBuckets) / 2)
+        rehash(NumBuckets);
+      else
+        rehash(NumBuckets ? NumBuckets * 2 : unsigned(Group::Width));
+    }
+
+    unsigned Idx = findInsertSlot(Hash);
+    if (Ctrl[Idx] == Group::CtrlEmpty)
+      --GrowthLeft;
+    Ctrl[Idx] = getH2(Hash);
+    BucketT *B = Buckets + Idx;
+    new (&B->getFirst()) KeyT(std::forward<KeyArgT>(Key));
+    new (&B->getSecond()) ValueT(std::forward<ValueArgTs>(Values)...);
+    ++NumEntries;
+    return std::make_pair(makeIterator(Idx, /*Advance=*/false), true);
+  }
+
+  void eraseBucket(unsigned Idx) {
+    assert(Group::isFull(Ctrl[Idx]) && "Erasing an unused bucket");
+    Buckets[Idx].~BucketT();
+    --NumEntries;
+    // If the group still has an empty bucket, no probe sequence goes past it
+    // and the bucket can be marked empty again. Otherwise later groups may
+    // hold keys that probed through this one, which must remain reachable.
+    Group Grp(Ctrl + (Idx & ~unsigned(Group::Width - 1)));
+    if (Grp.matchEmpty()) {
+      Ctrl[Idx] = Group::CtrlEmpty;
+      ++GrowthLeft;
+    } else {
+      Ctrl[Idx] = Group::CtrlDeleted;
+    }
+  }
+
+  void allocateBuckets(unsigned Num) {
+    assert(Num % Group::Width == 0 && isPowerOf2_32(Num) &&
+           "Bucket count must be a power of two multiple of the group width");
+    NumBuckets = Num;
+    Ctrl = new int8_t[Num];
+    std::memset(Ctrl, Group::CtrlEmpty, Num);
+    Buckets = static_cast<BucketT *>(operator new(sizeof(BucketT) * Num));
+    GrowthLeft = getMaxLoad(Num);
+  }
+
+  static void deallocateBuckets(int8_t *Ctrl, BucketT *Buckets) {
+    delete[] Ctrl;
+    operator delete(Buckets);
+  }
+
+  void destroyAll() {
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Group::isFull(Ctrl[I]))
+        Buckets[I].~BucketT();
+  }
+
+  /// Move all entries into a freshly allocated table of NewNumBuckets
+  /// buckets, which leaves no deleted buckets behind.
+  void rehash(unsigned NewNumBuckets) {
+    int8_t *OldCtrl = Ctrl;
+    BucketT *OldBuckets = Buckets;
+    unsigned OldNumBuckets = NumBuckets;
+
+    allocateBuckets(NewNumBuckets);
+    for (unsigned I = 0; I != OldNumBuckets; ++I) {
+      if (!Group::isFull(OldCtrl[I]))
+        continue;
+      BucketT &Old = OldBuckets[I];
+      uint64_t Hash = getHash(Old.getFirst());
+      unsigned Idx = findInsertSlot(Hash);
+      Ctrl[Idx] = getH2(Hash);
+      new (&Buckets[Idx].getFirst()) KeyT(std::move(Old.getFirst()));
+      new (&Buckets[Idx].getSecond()) ValueT(std::move(Old.getSecond()));
+      Old.~BucketT();
+    }
+    GrowthLeft -= NumEntries;
+    deallocateBuckets(OldCtrl, OldBuckets);
+  }
+};
+
+} // end namespace llvm
+
+#undef LLVM_SWISSMAP_SSE2
+
+#endif
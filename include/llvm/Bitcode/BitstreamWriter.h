@@ -230,6 +230,41 @@ public:
     }
   }
 
+  /// Emit a complete block whose contents were encoded by another writer.
+  /// \p Contents holds everything that follows the block size word of a
+  /// block entered there with EnterSubblock(BlockID, CodeLen), up to and
+  /// including its END_BLOCK and the padding to a 32-bit boundary. The result
+  /// is bit-identical to having emitted the block into this stream directly,
+  /// provided the other writer had the same BLOCKINFO abbreviations (see
+  /// CopyBlockInfoFrom).
+  void EmitEncodedBlock(unsigned BlockID, unsigned CodeLen,
+                        ArrayRef<char> Contents) {
+    assert((Contents.size() & 3) == 0 && "Block contents not 32-bit aligned");
+    EmitCode(bitc::ENTER_SUBBLOCK);
+    EmitVBR(BlockID, bitc::BlockIDWidth);
+    EmitVBR(CodeLen, bitc::CodeLenWidth);
+    FlushToWord();
+    Emit(Contents.size() / 4, bitc::BlockSizeWidth);
+    Out.append(Contents.begin(), Contents.end());
+  }
+
+  /// Install a copy of the BLOCKINFO abbreviations of \p Other in this
+  /// writer. The abbreviations are duplicated rather than shared, so the two
+  /// writers may then be used from different threads.
+  void CopyBlockInfoFrom(const BitstreamWriter &Other) {
+    assert(BlockInfoRecords.empty() && "Block info already emitted");
+    for (const BlockInfo &Info : Other.BlockInfoRecords) {
+      BlockInfoRecords.emplace_back();
+      BlockInfoRecords.back().BlockID = Info.BlockID;
+      for (const auto &Abbv : Info.Abbrevs) {
+        BitCodeAbbrev *Copy = new BitCodeAbbrev();
+        for (unsigned i = 0, e = Abbv->getNumOperandInfos(); i != e; ++i)
+          Copy->Add(Abbv->getOperandInfo(i));
+        BlockInfoRecords.back().Abbrevs.push_back(Copy);
+      }
+    }
+  }
+
   void ExitBlock() {
     assert(!BlockScope.empty() && "Block scope imbalance!");
     const Block &B = BlockScope.back();
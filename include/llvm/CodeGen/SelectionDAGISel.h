@@ -15,6 +15,8 @@
 #ifndef LLVM_CODEGEN_SELECTIONDAGISEL_H
 #define LLVM_CODEGEN_SELECTIONDAGISEL_H
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/IR/BasicBlock.h"
@@ -294,6 +296,17 @@ private:
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
 
+  /// SwitchCaseCache - This is a cache used to dispatch efficiently through
+  /// the large OPC_SwitchOpcode nodes nested in isel state machines. It maps
+  /// the index of the switch in the table and the opcode being switched on
+  /// to the index of the matching case, or zero if no case matches.
+  DenseMap<uint64_t, unsigned> SwitchCaseCache;
+
+  /// LargeSwitches - The table indices of the nested OPC_SwitchOpcode nodes
+  /// known to be large enough to go through SwitchCaseCache. Other switches
+  /// are scanned without paying for a hash lookup.
+  BitVector LargeSwitches;
+
   void UpdateChainsAndGlue(SDNode *NodeToMatch, SDValue InputChain,
                            const SmallVectorImpl<SDNode*> &ChainNodesMatched,
                            SDValue InputGlue, const SmallVectorImpl<SDNode*> &F,
@@ -55,6 +55,9 @@ class DWARFContext : public DIContext {
   std::unique_ptr<DWARFDebugAbbrev> AbbrevDWO;
   std::unique_ptr<DWARFDebugLocDWO> LocDWO;
 
+  /// The number of threads that may be used to index the units.
+  unsigned ThreadCount = 1;
+
   DWARFContext(DWARFContext &) = delete;
   DWARFContext &operator=(DWARFContext &) = delete;
 
@@ -165,6 +168,10 @@ public:
   /// Get a pointer to the parsed DebugAranges object.
   const DWARFDebugAranges *getDebugAranges();
 
+  /// Let the address index be built on up to \p Count threads. Clients that
+  /// already query several contexts concurrently should leave this at 1.
+  void setThreadCount(unsigned Count) { ThreadCount = Count; }
+
   /// Get a pointer to the parsed frame information object.
   const DWARFDebugFrame *getDebugFrame();
 
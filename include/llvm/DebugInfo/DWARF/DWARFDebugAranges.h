@@ -20,7 +20,9 @@ class DWARFContext;
 
 class DWARFDebugAranges {
 public:
-  void generate(DWARFContext *CTX);
+  /// Build the address ranges of \p CTX, walking the DIEs of the units that
+  /// .debug_aranges does not describe on up to \p ThreadCount threads.
+  void generate(DWARFContext *CTX, unsigned ThreadCount = 1);
   uint32_t findAddress(uint64_t Address) const;
 
 private:
@@ -20,6 +20,7 @@
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
@@ -39,6 +40,13 @@ public:
     bool RelativeAddresses : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// Budget, in bytes of debug information, of the modules kept in the
+    /// cache. The least recently used modules are evicted, along with the
+    /// binaries they were loaded from, when it is exceeded. Zero means that
+    /// modules are never evicted.
+    uint64_t MaxCacheSize = 0;
+    /// Number of threads each module may use to index its DWARF units.
+    unsigned ThreadCount = 1;
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
             bool RelativeAddresses = false, std::string DefaultArch = "")
@@ -65,39 +73,73 @@ public:
 private:
   typedef std::pair<ObjectFile*, ObjectFile*> ObjectPair;
 
+  /// The binaries, and the buffers they were parsed from, backing the objects
+  /// of a module.
+  struct OwnedBinaries {
+    SmallVector<std::unique_ptr<Binary>, 2> Binaries;
+    SmallVector<std::unique_ptr<MemoryBuffer>, 2> MemoryBuffers;
+    void addOwningBinary(OwningBinary<Binary> OwningBin) {
+      std::unique_ptr<Binary> Bin;
+      std::unique_ptr<MemoryBuffer> MemBuf;
+      std::tie(Bin, MemBuf) = OwningBin.takeBinary();
+      Binaries.push_back(std::move(Bin));
+      MemoryBuffers.push_back(std::move(MemBuf));
+    }
+  };
+
   ErrorOr<SymbolizableModule *>
   getOrCreateModuleInfo(const std::string &ModuleName);
+  /// Evict the least recently used modules until the cache fits in
+  /// Opts.MaxCacheSize, keeping at least the most recently used one.
+  void pruneCache();
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
-                             const std::string &ArchName);
+                             const std::string &ArchName,
+                             OwnedBinaries &Owner);
   ObjectFile *lookUpDebuglinkObject(const std::string &Path,
                                     const ObjectFile *Obj,
-                                    const std::string &ArchName);
+                                    const std::string &ArchName,
+                                    OwnedBinaries &Owner);
 
-  /// \brief Returns pair of pointers to object and debug object.
-  ErrorOr<ObjectPair> getOrCreateObjects(const std::string &Path,
-                                         const std::string &ArchName);
+  /// \brief Returns pair of pointers to object and debug object, the binaries
+  /// of which are added to \p Owner.
+  ErrorOr<ObjectPair> createObjects(const std::string &Path,
+                                    const std::string &ArchName,
+                                    OwnedBinaries &Owner);
   /// \brief Returns a parsed object file for a given architecture in a
   /// universal binary (or the binary itself if it is an object file).
   ErrorOr<ObjectFile *> getObjectFileFromBinary(Binary *Bin,
-                                                const std::string &ArchName);
-
-  // Owns all the parsed binaries and object files.
-  SmallVector<std::unique_ptr<Binary>, 4> ParsedBinariesAndObjects;
-  SmallVector<std::unique_ptr<MemoryBuffer>, 4> MemoryBuffers;
-  void addOwningBinary(OwningBinary<Binary> OwningBin) {
-    std::unique_ptr<Binary> Bin;
-    std::unique_ptr<MemoryBuffer> MemBuf;
-    std::tie(Bin, MemBuf) = OwningBin.takeBinary();
-    ParsedBinariesAndObjects.push_back(std::move(Bin));
-    MemoryBuffers.push_back(std::move(MemBuf));
-  }
+                                                const std::string &ArchName,
+                                                OwnedBinaries &Owner);
+
+  struct CachedModule {
+    /// Declared before Info, which refers to them, so that they outlive it.
+    OwnedBinaries Owner;
+    ErrorOr<std::unique_ptr<SymbolizableModule>> Info;
+    /// Size charged to the cache budget.
+    uint64_t Size;
+    /// Position in ModuleLRU.
+    std::list<std::string>::iterator LRUPos;
+
+    CachedModule(OwnedBinaries Owner,
+                 ErrorOr<std::unique_ptr<SymbolizableModule>> Info,
+                 uint64_t Size, std::list<std::string>::iterator LRUPos)
+        : Owner(std::move(Owner)), Info(std::move(Info)), Size(Size),
+          LRUPos(LRUPos) {}
+  };
+  /// Add the module \p ModuleName to the cache as the most recently used one,
+  /// then prune the cache.
+  ErrorOr<SymbolizableModule *>
+  addModule(const std::string &ModuleName, OwnedBinaries Owner,
+            ErrorOr<std::unique_ptr<SymbolizableModule>> Info, uint64_t Size);
 
-  std::map<std::string, ErrorOr<std::unique_ptr<SymbolizableModule>>> Modules;
-  std::map<std::pair<MachOUniversalBinary *, std::string>,
-           ErrorOr<ObjectFile *>> ObjectFileForArch;
-  std::map<std::pair<std::string, std::string>, ErrorOr<ObjectPair>>
-      ObjectPairForPathArch;
+  /// Every module, including the ones that failed to load, owning the
+  /// binaries it was loaded from.
+  std::map<std::string, CachedModule> Modules;
+  /// Names of the modules, most recently used first.
+  std::list<std::string> ModuleLRU;
+  /// Sum of the sizes of the modules in ModuleLRU.
+  uint64_t CacheSize = 0;
 
   Options Opts;
 };
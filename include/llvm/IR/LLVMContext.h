@@ -38,6 +38,12 @@ class DebugLoc;
 /// infrastructure, including the type and constant uniquing tables.
 /// LLVMContext itself provides no locking guarantees, so you should be careful
 /// to have one context per thread.
+///
+/// Locking the uniquing tables would not be enough to share a context between
+/// threads: constants, metadata and types are shared by every function in the
+/// context, and creating any instruction that uses a constant appends to that
+/// constant's use list.  Code that builds or optimizes functions in parallel
+/// should give each thread its own context and module.
 class LLVMContext {
 public:
   LLVMContextImpl *const pImpl;
@@ -0,0 +1,72 @@
+//===-LTOObjectCache.h - On-disk cache of LTO backend outputs -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the LTOObjectCache class, which lets LTO drivers reuse
+// the native object files produced for a module (or a partition of one) by an
+// earlier link, as long as nothing that determines their contents changed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LTO_LTOOBJECTCACHE_H
+#define LLVM_LTO_LTOOBJECTCACHE_H
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+class Module;
+
+/// An on-disk cache of the objects generated by LTO backends.
+///
+/// Entries are keyed by a hash of the bitcode of the module that is about to
+/// be optimized and code generated, after any function importing took place,
+/// together with a description of the options used to generate it. The key
+/// thus covers the input bitcode, the set of imported functions, the
+/// optimization and code generation options and the target triple.
+///
+/// Several processes may share a cache directory: an entry is only produced by
+/// one of them at a time, coordinated through LockFileManager, and entries are
+/// published by atomically renaming a complete file into place.
+class LTOObjectCache {
+  SmallString<128> CacheDir;
+
+  /// Return the path of the cache entry for \p Key.
+  SmallString<128> getEntryPath(StringRef Key) const;
+
+  /// Return the contents of the cache entry for \p Key, or null on a miss.
+  std::unique_ptr<MemoryBuffer> lookup(StringRef Key) const;
+
+  /// Atomically publish \p Object as the cache entry for \p Key. Failures are
+  /// ignored, as the cache is only an optimization.
+  void store(StringRef Key, StringRef Object) const;
+
+public:
+  /// Create a cache rooted at \p CacheDir, which is created if it does not
+  /// exist yet.
+  explicit LTOObjectCache(StringRef CacheDir);
+
+  /// Compute the cache key of \p M, which must be fully materialized.
+  /// \p Options is an opaque description of every option, beyond the target
+  /// triple of \p M, that influences the generated object.
+  static std::string computeKey(const Module &M, StringRef Options);
+
+  /// Return the object for \p Key, calling \p Generate to produce it if the
+  /// cache does not already hold it. If another process is already generating
+  /// the same entry, wait for it to finish and reuse its result.
+  std::unique_ptr<MemoryBuffer>
+  getOrGenerate(StringRef Key,
+                function_ref<std::unique_ptr<MemoryBuffer>()> Generate) const;
+};
+}
+
+#endif
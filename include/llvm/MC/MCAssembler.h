@@ -10,6 +10,7 @@
 #ifndef LLVM_MC_MCASSEMBLER_H
 #define LLVM_MC_MCASSEMBLER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
@@ -610,6 +611,9 @@ private:
   unsigned RelaxAll : 1;
   unsigned SubsectionsViaSymbols : 1;
 
+  /// The number of threads the object writer may use to encode the object.
+  unsigned ThreadCount;
+
   /// ELF specific e_header flags
   // It would be good if there were an MCELFAssembler class to hold this.
   // ELF header flags are used both by the integrated and standalone assemblers.
@@ -650,13 +654,29 @@ private:
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
                                const MCAsmLayout &Layout) const;
 
+  /// The fragments of a section whose size may still change during
+  /// relaxation, in layout order.
+  typedef std::vector<MCFragment *> RelaxationWorklist;
+
+  /// \brief Check whether the size of \p F may still change during
+  /// relaxation.
+  bool mayNeedRelaxation(const MCFragment &F) const;
+
   /// \brief Perform one layout iteration and return true if any offsets
-  /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  /// were adjusted. \p Worklists holds the worklist of every section, indexed
+  /// by section ordinal.
+  bool layoutOnce(MCAsmLayout &Layout,
+                  MutableArrayRef<RelaxationWorklist> Worklists);
 
   /// \brief Perform one layout iteration of the given section and return true
-  /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec);
+  /// if any offsets were adjusted. Only the fragments in \p Worklist are
+  /// visited, and those which can no longer change size are dropped from it.
+  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                         RelaxationWorklist &Worklist);
+
+  /// \brief Recompute the size of \p F, which must need relaxation, and
+  /// return true if it changed.
+  bool relaxFragment(MCAsmLayout &Layout, MCFragment &F);
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
@@ -753,6 +773,9 @@ public:
   bool getRelaxAll() const { return RelaxAll; }
   void setRelaxAll(bool Value) { RelaxAll = Value; }
 
+  unsigned getThreadCount() const { return ThreadCount; }
+  void setThreadCount(unsigned Value) { ThreadCount = Value; }
+
   bool isBundlingEnabled() const { return BundleAlignSize != 0; }
 
   unsigned getBundleAlignSize() const { return BundleAlignSize; }
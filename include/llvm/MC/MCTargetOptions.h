@@ -36,6 +36,9 @@ public:
   bool ShowMCInst : 1;
   bool AsmVerbose : 1;
   int DwarfVersion;
+  /// The number of threads the object writer may use. Clients that already
+  /// run several code generators concurrently should leave this at 1.
+  unsigned ObjectWriterThreads;
   /// getABIName - If this returns a non-empty string this represents the
   /// textual name of the ABI that we want the backend to use, e.g. o32, or
   /// aapcs-linux.
@@ -36,6 +36,11 @@ cl::opt<bool> RelaxAll("mc-relax-all",
 cl::opt<int> DwarfVersion("dwarf-version", cl::desc("Dwarf version"),
                           cl::init(0));
 
+cl::opt<unsigned> ObjectWriterThreads(
+    "object-writer-threads", cl::init(1), cl::value_desc("N"),
+    cl::desc("When used with filetype=obj, encode the object file on up to N "
+             "threads"));
+
 cl::opt<bool> ShowMCInst("asm-show-inst",
                          cl::desc("Emit internal instruction representation to "
                                   "assembly file"));
@@ -57,6 +62,7 @@ static inline MCTargetOptions InitMCTargetOptionsFromFlags() {
       (AsmInstrumentation == MCTargetOptions::AsmInstrumentationAddress);
   Options.MCRelaxAll = RelaxAll;
   Options.DwarfVersion = DwarfVersion;
+  Options.ObjectWriterThreads = ObjectWriterThreads;
   Options.ShowMCInst = ShowMCInst;
   Options.ABIName = ABIName;
   Options.MCFatalWarnings = FatalWarnings;
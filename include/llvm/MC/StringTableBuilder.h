@@ -10,6 +10,7 @@
 #ifndef LLVM_MC_STRINGTABLEBUILDER_H
 #define LLVM_MC_STRINGTABLEBUILDER_H
 
+#include "llvm/ADT/CachedHashString.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/DenseMap.h"
 #include <cassert>
@@ -17,13 +18,16 @@
 namespace llvm {
 
 /// \brief Utility for building string tables with deduplicated suffixes.
+///
+/// The builder only keeps references to the strings it is given, which must
+/// outlive it; their bytes are only copied into the final table.
 class StringTableBuilder {
 public:
   enum Kind { ELF, WinCOFF, MachO, RAW };
 
 private:
   SmallString<256> StringTable;
-  DenseMap<StringRef, size_t> StringIndexMap;
+  DenseMap<CachedHashStringRef, size_t> StringIndexMap;
   size_t Size = 0;
   Kind K;
 
@@ -33,11 +37,13 @@ public:
   /// \brief Add a string to the builder. Returns the position of S in the
   /// table. The position will be changed if finalize is used.
   /// Can only be used before the table is finalized.
-  size_t add(StringRef S);
+  size_t add(CachedHashStringRef S);
+  size_t add(StringRef S) { return add(CachedHashStringRef(S)); }
 
   /// \brief Analyze the strings and build the final table. No more strings can
-  /// be added after this point.
-  void finalize();
+  /// be added after this point. Large tables are sorted on up to
+  /// \p ThreadCount threads.
+  void finalize(unsigned ThreadCount = 1);
 
   /// \brief Retrieve the string table data. Can only be used after the table
   /// is finalized.
@@ -48,9 +54,14 @@ public:
 
   /// \brief Get the offest of a string in the string table. Can only be used
   /// after the table is finalized.
-  size_t getOffset(StringRef S) const;
+  size_t getOffset(CachedHashStringRef S) const;
+  size_t getOffset(StringRef S) const {
+    return getOffset(CachedHashStringRef(S));
+  }
 
-  const DenseMap<StringRef, size_t> &getMap() const { return StringIndexMap; }
+  const DenseMap<CachedHashStringRef, size_t> &getMap() const {
+    return StringIndexMap;
+  }
   size_t getSize() const { return Size; }
   void clear();
 
@@ -39,10 +39,17 @@ public:
   const sys::fs::file_status &getStatus() const;
 };
 
+/// Write an archive holding \p NewMembers to \p ArcName.
+///
+/// The members are read on up to \p ThreadCount threads to build the symbol
+/// table. If \p ReuseOldSymtab is true, the entries of the members taken from
+/// an existing archive that has a symbol table are copied from that table
+/// instead of being recomputed, so that replacing a few members of a large
+/// archive only reads the new ones.
 std::pair<StringRef, std::error_code>
 writeArchive(StringRef ArcName, std::vector<NewArchiveIterator> &NewMembers,
              bool WriteSymtab, object::Archive::Kind Kind, bool Deterministic,
-             bool Thin);
+             bool Thin, bool ReuseOldSymtab = false, unsigned ThreadCount = 1);
 }
 
 #endif
@@ -112,6 +112,19 @@ public:
   ///
   void stopTimer();
 
+  /// isRunning - Return true if the timer has been started and not stopped
+  /// since.
+  bool isRunning() const;
+
+  /// hasTriggered - Return true if the timer has been started since it was
+  /// created or its group was last printed.
+  bool hasTriggered() const;
+
+  /// getTotalTime - Return the time accumulated by the timer since it was
+  /// created or its group was last printed. Only meaningful while the timer is
+  /// not running.
+  TimeRecord getTotalTime() const;
+
 private:
   friend class TimerGroup;
 };
@@ -27,6 +27,13 @@ class StringRef;
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
+/// By default, global values are assigned to partitions by hashing their names
+/// and local values are externalized. If PreserveLocals is true, global values
+/// are instead grouped into clusters that keep comdats, aliases and local
+/// values together with their users, so that locals stay local, and the
+/// clusters are distributed to balance the number of instructions in each
+/// partition.
+///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
 ///
@@ -36,7 +43,8 @@ class StringRef;
 ///   each partition.
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
-    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback);
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback,
+    bool PreserveLocals = false);
 
 } // End llvm namespace
 
@@ -33,11 +33,16 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cctype>
 #include <map>
 using namespace llvm;
 
+static cl::opt<unsigned> WriterThreads(
+    "bitcode-writer-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to encode function blocks"));
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -2469,16 +2474,11 @@ static void SaveFunctionInfo(
       llvm::make_unique<FunctionInfo>(BitcodeIndex, std::move(FuncSummary));
 }
 
-/// Emit a function body to the module stream.
-static void WriteFunction(
-    const Function &F, ValueEnumerator &VE, BitstreamWriter &Stream,
-    DenseMap<const Function *, std::unique_ptr<FunctionInfo>> &FunctionIndex,
-    bool EmitFunctionSummary) {
-  // Save the bitcode index of the start of this function block for recording
-  // in the VST.
-  uint64_t BitcodeIndex = Stream.GetCurrentBitNo();
-
-  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+/// Emit the contents of the function block for \p F, which the caller has
+/// already entered. Returns the number of instructions, not counting debug
+/// intrinsics, for the function summary.
+static unsigned WriteFunctionContents(const Function &F, ValueEnumerator &VE,
+                                      BitstreamWriter &Stream) {
   VE.incorporateFunction(F);
 
   SmallVector<unsigned, 64> Vals;
@@ -2549,12 +2549,105 @@ static void WriteFunction(
   if (VE.shouldPreserveUseListOrder())
     WriteUseListBlock(&F, VE, Stream);
   VE.purgeFunction();
+  return NumInsts;
+}
+
+/// Emit a function body to the module stream.
+static void WriteFunction(
+    const Function &F, ValueEnumerator &VE, BitstreamWriter &Stream,
+    DenseMap<const Function *, std::unique_ptr<FunctionInfo>> &FunctionIndex,
+    bool EmitFunctionSummary) {
+  // Save the bitcode index of the start of this function block for recording
+  // in the VST.
+  uint64_t BitcodeIndex = Stream.GetCurrentBitNo();
+
+  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+  unsigned NumInsts = WriteFunctionContents(F, VE, Stream);
   Stream.ExitBlock();
 
   SaveFunctionInfo(F, FunctionIndex, NumInsts, BitcodeIndex,
                    EmitFunctionSummary);
 }
 
+namespace {
+/// A function block encoded ahead of time by WriteFunctionsInParallel, as a
+/// byte range of the buffer of the worker that encoded it.
+struct EncodedFunction {
+  const Function *F;
+  size_t Begin, End;
+  unsigned NumInsts;
+};
+
+/// The contiguous run of function bodies encoded by one worker.
+struct EncodedFunctionChunk {
+  std::vector<const Function *> Functions;
+  std::vector<EncodedFunction> Encoded;
+  SmallVector<char, 0> Buffer;
+};
+}
+
+/// Emit the bodies of the defined functions of \p M, encoding them on
+/// \p NumThreads threads before splicing them into \p Stream in module order.
+///
+/// Every worker enumerates the module with its own ValueEnumerator, which
+/// assigns the same IDs as the one used for the rest of the module, and
+/// encodes its share of the function blocks into a private buffer with a copy
+/// of the BLOCKINFO abbreviations of \p Stream. Function blocks are 32-bit
+/// aligned and do not reference absolute stream positions, so the result is
+/// identical to the serial writer.
+static void WriteFunctionsInParallel(
+    const Module *M, BitstreamWriter &Stream,
+    DenseMap<const Function *, std::unique_ptr<FunctionInfo>> &FunctionIndex,
+    bool EmitFunctionSummary, unsigned NumThreads) {
+  // Split the function bodies into contiguous chunks of roughly the same
+  // number of instructions.
+  uint64_t TotalSize = 0;
+  for (const Function &F : *M)
+    for (const BasicBlock &BB : F)
+      TotalSize += BB.size();
+
+  std::vector<EncodedFunctionChunk> Chunks(1);
+  uint64_t ChunkSize = 0;
+  for (const Function &F : *M) {
+    if (F.isDeclaration())
+      continue;
+    if (ChunkSize * NumThreads >= TotalSize && Chunks.size() < NumThreads) {
+      Chunks.emplace_back();
+      ChunkSize = 0;
+    }
+    Chunks.back().Functions.push_back(&F);
+    for (const BasicBlock &BB : F)
+      ChunkSize += BB.size();
+  }
+
+  {
+    ThreadPool Pool(Chunks.size());
+    for (EncodedFunctionChunk &Chunk : Chunks)
+      Pool.async([M, &Stream, &Chunk]() {
+        ValueEnumerator VE(*M, /*ShouldPreserveUseListOrder=*/false);
+        BitstreamWriter ChunkStream(Chunk.Buffer);
+        ChunkStream.CopyBlockInfoFrom(Stream);
+        for (const Function *F : Chunk.Functions) {
+          ChunkStream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+          size_t Begin = ChunkStream.GetCurrentBitNo() / 8;
+          unsigned NumInsts = WriteFunctionContents(*F, VE, ChunkStream);
+          ChunkStream.ExitBlock();
+          Chunk.Encoded.push_back({F, Begin, Chunk.Buffer.size(), NumInsts});
+        }
+      });
+  }
+
+  for (const EncodedFunctionChunk &Chunk : Chunks)
+    for (const EncodedFunction &EF : Chunk.Encoded) {
+      uint64_t BitcodeIndex = Stream.GetCurrentBitNo();
+      Stream.EmitEncodedBlock(
+          bitc::FUNCTION_BLOCK_ID, 4,
+          makeArrayRef(Chunk.Buffer.data() + EF.Begin, EF.End - EF.Begin));
+      SaveFunctionInfo(*EF.F, FunctionIndex, EF.NumInsts, BitcodeIndex,
+                       EmitFunctionSummary);
+    }
+}
+
 // Emit blockinfo, which defines the standard abbreviations etc.
 static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   // We only want to emit block info records for blocks that have multiple
@@ -2814,15 +2907,20 @@ static void WritePerModuleFunctionSummary(
   unsigned FSAbbrev = Stream.EmitAbbrev(Abbv);
 
   SmallVector<unsigned, 64> NameVals;
-  for (auto &I : FunctionIndex) {
+  // Iterate over the functions in module order, rather than over the
+  // pointer-keyed FunctionIndex, so that the output is deterministic.
+  for (const Function &F : *M) {
+    if (F.isDeclaration())
+      continue;
     // Skip anonymous functions. We will emit a function summary for
     // any aliases below.
-    if (!I.first->hasName())
+    if (!F.hasName())
       continue;
 
+    assert(FunctionIndex.count(&F) == 1);
     WritePerModuleFunctionSummaryRecord(
-        NameVals, I.second->functionSummary(),
-        VE.getValueID(M->getValueSymbolTable().lookup(I.first->getName())),
+        NameVals, FunctionIndex[&F]->functionSummary(),
+        VE.getValueID(M->getValueSymbolTable().lookup(F.getName())),
         FSAbbrev, Stream);
   }
 
@@ -2950,11 +3048,16 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
 
   WriteOperandBundleTags(M, Stream);
 
-  // Emit function bodies.
+  // Emit function bodies. Use-list orders are predicted for the whole module
+  // and consumed function by function, so they force the serial writer.
   DenseMap<const Function *, std::unique_ptr<FunctionInfo>> FunctionIndex;
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream, FunctionIndex, EmitFunctionSummary);
+  if (WriterThreads > 1 && !VE.shouldPreserveUseListOrder())
+    WriteFunctionsInParallel(M, Stream, FunctionIndex, EmitFunctionSummary,
+                             WriterThreads);
+  else
+    for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+      if (!F->isDeclaration())
+        WriteFunction(*F, VE, Stream, FunctionIndex, EmitFunctionSummary);
 
   // Need to write after the above call to WriteFunction which populates
   // the summary information in the index.
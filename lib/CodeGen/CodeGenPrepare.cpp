@@ -72,6 +72,8 @@ STATISTIC(NumDbgValueMoved, "Number of debug value instructions moved");
 STATISTIC(NumSelectsExpanded, "Number of selects turned into branches");
 STATISTIC(NumAndCmpsMoved, "Number of and/cmp's pushed into branches");
 STATISTIC(NumStoreExtractExposed, "Number of store(extractelement) exposed");
+STATISTIC(NumSunkIntoRegion, "Number of instructions sunk to their user "
+                             "within a single-entry region");
 
 static cl::opt<bool> DisableBranchOpts(
   "disable-cgp-branch-opts", cl::Hidden, cl::init(false),
@@ -111,6 +113,11 @@ static cl::opt<bool> StressExtLdPromotion(
     cl::desc("Stress test ext(promotable(ld)) -> promoted(ext(ld)) "
              "optimization in CodeGenPrepare"));
 
+static cl::opt<bool> EnableRegionSinking(
+    "cgp-region-sinking", cl::Hidden, cl::init(false),
+    cl::desc("Sink single-use computations to their user within single-entry "
+             "regions, so that instruction selection sees them together"));
+
 namespace {
 typedef SmallPtrSet<Instruction *, 16> SetOfInstrs;
 typedef PointerIntPair<Type *, 1, bool> TypeIsSExt;
@@ -184,6 +191,7 @@ class TypePromotionTransaction;
     bool dupRetToEnableTailCallOpts(BasicBlock *BB);
     bool placeDbgValues(Function &F);
     bool sinkAndCmp(Function &F);
+    bool sinkIntoRegionUsers(Function &F);
     bool extLdPromotion(TypePromotionTransaction &TPT, LoadInst *&LI,
                         Instruction *&Inst,
                         const SmallVectorImpl<Instruction *> &Exts,
@@ -247,6 +255,9 @@ bool CodeGenPrepare::runOnFunction(Function &F) {
     EverMadeChange |= splitBranchCondition(F);
   }
 
+  if (EnableRegionSinking)
+    EverMadeChange |= sinkIntoRegionUsers(F);
+
   bool MadeChange = true;
   while (MadeChange) {
     MadeChange = false;
@@ -5336,6 +5347,84 @@ bool CodeGenPrepare::sinkAndCmp(Function &F) {
   return MadeChange;
 }
 
+/// Return true if every path to \p UserBB goes through \p DefBB, following a
+/// chain of blocks with a single predecessor, so that \p UserBB is part of
+/// the single-entry region headed by \p DefBB and never runs more often.
+static bool isInSingleEntryRegionOf(const BasicBlock *UserBB,
+                                    const BasicBlock *DefBB) {
+  // Bound the walk: regions deeper than this are not worth the compile time.
+  const unsigned MaxRegionDepth = 8;
+  const BasicBlock *BB = UserBB;
+  for (unsigned Depth = 0; Depth != MaxRegionDepth; ++Depth) {
+    BB = BB->getSinglePredecessor();
+    if (!BB || BB == UserBB)
+      return false;
+    if (BB == DefBB)
+      return true;
+  }
+  return false;
+}
+
+/// Return true if the value of \p V has to be exported from its block for a
+/// use in another block, either already or once \p I uses it from elsewhere.
+static bool isLiveOutOfBlock(const Value *V, const Instruction *I) {
+  const Instruction *VI = dyn_cast<Instruction>(V);
+  if (!VI || VI->getParent() != I->getParent())
+    // Arguments, constants and values from other blocks are available
+    // everywhere already.
+    return true;
+  for (const User *U : VI->users())
+    if (U != I && cast<Instruction>(U)->getParent() != VI->getParent())
+      return true;
+  return false;
+}
+
+// SelectionDAG instructions are selected one block at a time, so a computation
+// in one block whose only user lives in another cannot be folded into that
+// user, and its result has to be copied through a virtual register. Within a
+// single-entry region, a block whose predecessors form a single chain back to
+// the region's entry executes at most as often as the blocks on that chain.
+// Sinking such computations down to their user is thus never slower, and lets
+// instruction selection fold them, as long as it does not force more values
+// to be copied across blocks.
+bool CodeGenPrepare::sinkIntoRegionUsers(Function &F) {
+  bool MadeChange = false;
+  for (BasicBlock &BB : F) {
+    // Visit the instructions bottom-up, so that the operands of a sunk
+    // instruction are considered after it.
+    for (BasicBlock::iterator II = BB.end(); II != BB.begin();) {
+      Instruction *I = &*--II;
+      if (isa<PHINode>(I) || isa<TerminatorInst>(I) || I->isEHPad() ||
+          isa<AllocaInst>(I) || isa<CallInst>(I) || isa<LandingPadInst>(I) ||
+          I->mayHaveSideEffects() || I->mayReadFromMemory() ||
+          !I->hasOneUse())
+        continue;
+
+      Instruction *User = cast<Instruction>(*I->user_begin());
+      BasicBlock *UserBB = User->getParent();
+      if (isa<PHINode>(User) || User->isEHPad() || UserBB == &BB ||
+          !isInSingleEntryRegionOf(UserBB, &BB))
+        continue;
+
+      // The result of I no longer needs to be exported; allow at most one of
+      // its operands to take its place.
+      unsigned NewLiveOuts = 0;
+      for (const Value *Op : I->operands())
+        if (!isLiveOutOfBlock(Op, I))
+          ++NewLiveOuts;
+      if (NewLiveOuts > 1)
+        continue;
+
+      // Step the iterator past I before moving it away.
+      ++II;
+      I->moveBefore(User);
+      ++NumSunkIntoRegion;
+      MadeChange = true;
+    }
+  }
+  return MadeChange;
+}
+
 /// \brief Retrieve the probabilities of a conditional branch. Returns true on
 /// success, or returns false if no or invalid metadata was found.
 static bool extractBranchMetadata(BranchInst *BI,
@@ -24,6 +24,7 @@
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectStreamer.h"
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Support/CommandLine.h"
@@ -204,6 +205,9 @@ bool LLVMTargetMachine::addPassesToEmitFile(
     AsmStreamer.reset(getTarget().createMCObjectStreamer(
         T, *Context, *MAB, Out, MCE, STI, Options.MCOptions.MCRelaxAll,
         /*DWARFMustBeAtTheEnd*/ true));
+    static_cast<MCObjectStreamer &>(*AsmStreamer)
+        .getAssembler()
+        .setThreadCount(Options.MCOptions.ObjectWriterThreads);
     break;
   }
   case CGFT_Null:
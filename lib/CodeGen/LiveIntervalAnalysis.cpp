@@ -19,6 +19,7 @@
 #include "LiveRangeCalc.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveVariables.h"
 #include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
@@ -43,6 +44,10 @@ using namespace llvm;
 
 #define DEBUG_TYPE "regalloc"
 
+STATISTIC(NumVirtRegIntervals, "Number of virtual register intervals computed");
+STATISTIC(NumVirtRegSegments,  "Number of live segments in computed intervals");
+STATISTIC(VNInfoBytes,         "Bytes allocated for value numbers");
+
 char LiveIntervals::ID = 0;
 char &llvm::LiveIntervalsID = LiveIntervals::ID;
 INITIALIZE_PASS_BEGIN(LiveIntervals, "liveintervals",
@@ -139,6 +144,7 @@ bool LiveIntervals::runOnMachineFunction(MachineFunction &fn) {
   computeVirtRegs();
   computeRegMasks();
   computeLiveInRegUnits();
+  VNInfoBytes += getVNInfoAllocator().getTotalMemory();
 
   if (EnablePrecomputePhysRegs) {
     // For stress testing, precompute live ranges of all physical register
@@ -200,6 +206,8 @@ void LiveIntervals::computeVirtRegInterval(LiveInterval &LI) {
   bool ShouldTrackSubRegLiveness = MRI->shouldTrackSubRegLiveness(LI.reg);
   LRCalc->reset(MF, getSlotIndexes(), DomTree, &getVNInfoAllocator());
   LRCalc->calculate(LI, ShouldTrackSubRegLiveness);
+  ++NumVirtRegIntervals;
+  NumVirtRegSegments += LI.size();
   bool SeparatedComponents = computeDeadValues(LI, nullptr);
   if (SeparatedComponents) {
     assert(ShouldTrackSubRegLiveness
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "LiveRangeCalc.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 
@@ -19,10 +20,24 @@ using namespace llvm;
 
 #define DEBUG_TYPE "regalloc"
 
+STATISTIC(NumSparseResets, "Number of live-out maps reset block by block");
+STATISTIC(NumFullResets,   "Number of live-out maps reset entirely");
+
 void LiveRangeCalc::resetLiveOutMap() {
   unsigned NumBlocks = MF->getNumBlockIDs();
-  Seen.clear();
-  Seen.resize(NumBlocks);
+  // Clearing individual bits beats clearing the whole vector as long as there
+  // are fewer of them than words in the vector. A map in which no block was
+  // seen needs no clearing at all.
+  if (Seen.size() != NumBlocks || SeenBlocks.size() > NumBlocks / 64) {
+    ++NumFullResets;
+    Seen.clear();
+    Seen.resize(NumBlocks);
+  } else if (!SeenBlocks.empty()) {
+    ++NumSparseResets;
+    for (unsigned Num : SeenBlocks)
+      Seen.reset(Num);
+  }
+  SeenBlocks.clear();
   Map.resize(NumBlocks);
 }
 
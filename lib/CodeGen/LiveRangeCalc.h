@@ -24,6 +24,7 @@
 
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/IndexedMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/LiveInterval.h"
 
 namespace llvm {
@@ -53,6 +54,12 @@ class LiveRangeCalc {
   /// when switching live ranges.
   BitVector Seen;
 
+  /// Numbers of the blocks with a Seen bit.  Most live ranges only touch a
+  /// handful of blocks, so resetLiveOutMap can clear just these bits instead
+  /// of the whole bit vector, which would make computing the live ranges of
+  /// all virtual registers quadratic in huge functions.
+  SmallVector<unsigned, 16> SeenBlocks;
+
   /// Map each basic block where a live range is live out to the live-out value
   /// and its defining block.
   ///
@@ -209,7 +216,11 @@ public:
   /// VNI may be null only if MBB is a live-through block also passed to
   /// addLiveInBlock().
   void setLiveOutValue(MachineBasicBlock *MBB, VNInfo *VNI) {
-    Seen.set(MBB->getNumber());
+    unsigned Num = MBB->getNumber();
+    if (!Seen.test(Num)) {
+      Seen.set(Num);
+      SeenBlocks.push_back(Num);
+    }
     Map[MBB] = LiveOutPair(VNI, nullptr);
   }
 
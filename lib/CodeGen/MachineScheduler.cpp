@@ -14,6 +14,7 @@
 
 #include "llvm/CodeGen/MachineScheduler.h"
 #include "llvm/ADT/PriorityQueue.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
 #include "llvm/CodeGen/MachineDominators.h"
@@ -35,6 +36,8 @@ using namespace llvm;
 
 #define DEBUG_TYPE "misched"
 
+STATISTIC(NumChainRegions, "Number of dependence chain regions not scheduled");
+
 namespace llvm {
 cl::opt<bool> ForceTopDown("misched-topdown", cl::Hidden,
                            cl::desc("Force top-down list scheduling"));
@@ -81,6 +84,10 @@ static cl::opt<bool> EnableMacroFusion("misched-fusion", cl::Hidden,
 static cl::opt<bool> VerifyScheduling("verify-misched", cl::Hidden,
   cl::desc("Verify machine instrs before and after machine scheduling"));
 
+static cl::opt<bool> SkipChainRegions("misched-skip-chains", cl::Hidden,
+  cl::desc("Don't build a DAG for regions that are a dependence chain"),
+  cl::init(true));
+
 // DAG subtrees must have at least this many nodes.
 static const unsigned MinSubtreeSize = 8;
 
@@ -658,12 +665,56 @@ bool ScheduleDAGMI::checkSchedLimit() {
   return true;
 }
 
+/// Return true if MI reads a register defined by Def, which makes the DAG
+/// builder add a data dependence between them.
+static bool readsDefOf(const MachineInstr &MI, const MachineInstr &Def,
+                       const TargetRegisterInfo *TRI) {
+  for (const MachineOperand &DefMO : Def.operands()) {
+    if (!DefMO.isReg() || !DefMO.isDef() || !DefMO.getReg())
+      continue;
+    unsigned Reg = DefMO.getReg();
+    for (const MachineOperand &MO : MI.operands()) {
+      if (!MO.isReg() || !MO.readsReg() || !MO.getReg())
+        continue;
+      if (MO.getReg() == Reg ||
+          (TargetRegisterInfo::isPhysicalRegister(Reg) &&
+           TargetRegisterInfo::isPhysicalRegister(MO.getReg()) &&
+           TRI->regsOverlap(Reg, MO.getReg())))
+        return true;
+    }
+  }
+  return false;
+}
+
+/// Return true if every instruction in [Begin, End) reads a register defined by
+/// the instruction right above it. Such a region has a single topological
+/// order, so scheduling it can only reproduce the current order. Regions with
+/// debug values are not considered, their placement is left to the scheduler.
+static bool isDependenceChain(MachineBasicBlock::iterator Begin,
+                              MachineBasicBlock::iterator End,
+                              const TargetRegisterInfo *TRI) {
+  const MachineInstr *Prev = nullptr;
+  for (MachineBasicBlock::iterator I = Begin; I != End; ++I) {
+    if (I->isDebugValue())
+      return false;
+    if (Prev && !readsDefOf(*I, *Prev, TRI))
+      return false;
+    Prev = &*I;
+  }
+  return true;
+}
+
 /// Per-region scheduling driver, called back from
 /// MachineScheduler::runOnMachineFunction. This is a simplified driver that
 /// does not consider liveness or register pressure. It is useful for PostRA
 /// scheduling and potentially other custom schedulers.
 void ScheduleDAGMI::schedule() {
   DEBUG(dbgs() << "ScheduleDAGMI::schedule starting\n");
+  if (SkipChainRegions && isDependenceChain(RegionBegin, RegionEnd, TRI)) {
+    DEBUG(dbgs() << "Region is a dependence chain, not scheduling it\n");
+    ++NumChainRegions;
+    return;
+  }
   DEBUG(SchedImpl->dumpPolicy());
 
   // Build the DAG.
@@ -1028,6 +1079,11 @@ void ScheduleDAGMILive::updatePressureDiffs(ArrayRef<unsigned> LiveUses) {
 /// to update any specialized state.
 void ScheduleDAGMILive::schedule() {
   DEBUG(dbgs() << "ScheduleDAGMILive::schedule starting\n");
+  if (SkipChainRegions && isDependenceChain(RegionBegin, RegionEnd, TRI)) {
+    DEBUG(dbgs() << "Region is a dependence chain, not scheduling it\n");
+    ++NumChainRegions;
+    return;
+  }
   DEBUG(SchedImpl->dumpPolicy());
   buildDAGWithRegPressure();
 
@@ -12,19 +12,32 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
-#include "llvm/Support/thread.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
 
 using namespace llvm;
 
+// Returns the number of instructions defined in M, as reported next to the
+// time taken by the code generation of each partition.
+static uint64_t getInstructionCount(const Module &M) {
+  uint64_t Count = 0;
+  for (const Function &F : M)
+    for (const BasicBlock &BB : F)
+      Count += BB.size();
+  return Count;
+}
+
 static void codegen(Module *M, llvm::raw_pwrite_stream &OS,
                     const Target *TheTarget, StringRef CPU, StringRef Features,
                     const TargetOptions &Options, Reloc::Model RM,
@@ -57,40 +70,58 @@ llvm::splitCodeGen(std::unique_ptr<Module> M,
     return M;
   }
 
-  std::vector<thread> Threads;
-  SplitModule(std::move(M), OSs.size(), [&](std::unique_ptr<Module> MPart) {
-    // We want to clone the module in a new context to multi-thread the codegen.
-    // We do it by serializing partition modules to bitcode (while still on the
-    // main thread, in order to avoid data races) and spinning up new threads
-    // which deserialize the partitions into separate contexts.
-    // FIXME: Provide a more direct way to do this in LLVM.
-    SmallVector<char, 0> BC;
-    raw_svector_ostream BCOS(BC);
-    WriteBitcodeToFile(MPart.get(), BCOS);
+  // Create ThreadPool in nested scope so that threads will be joined
+  // on destruction, before the partition timers are reported.
+  {
+    TimerGroup CodegenTimerGroup("Parallel code generation");
+    std::vector<Timer> PartitionTimers(OSs.size());
+    ThreadPool CodegenThreadPool(OSs.size());
+    int ThreadCount = 0;
 
-    llvm::raw_pwrite_stream *ThreadOS = OSs[Threads.size()];
-    Threads.emplace_back(
-        [TheTarget, CPU, Features, Options, RM, CM, OL, FileType,
-         ThreadOS](const SmallVector<char, 0> &BC) {
-          LLVMContext Ctx;
-          ErrorOr<std::unique_ptr<Module>> MOrErr =
-              parseBitcodeFile(MemoryBufferRef(StringRef(BC.data(), BC.size()),
-                                               "<split-module>"),
-                               Ctx);
-          if (!MOrErr)
-            report_fatal_error("Failed to read bitcode");
-          std::unique_ptr<Module> MPartInCtx = std::move(MOrErr.get());
+    // Split without externalizing locals, balancing the number of
+    // instructions of each partition so that no partition dominates the wall
+    // time of code generation.
+    SplitModule(std::move(M), OSs.size(), [&](std::unique_ptr<Module> MPart) {
+      // We want to clone the module in a new context to multi-thread the
+      // codegen. We do it by serializing partition modules to bitcode (while
+      // still on the main thread, in order to avoid data races) and spinning
+      // up new threads which deserialize the partitions into separate contexts.
+      // FIXME: Provide a more direct way to do this in LLVM.
+      SmallVector<char, 0> BC;
+      raw_svector_ostream BCOS(BC);
+      WriteBitcodeToFile(MPart.get(), BCOS);
 
-          codegen(MPartInCtx.get(), *ThreadOS, TheTarget, CPU, Features,
-                  Options, RM, CM, OL, FileType);
-        },
-        // Pass BC using std::move to ensure that it get moved rather than
-        // copied into the thread's context.
-        std::move(BC));
-  });
+      Timer *PartitionTimer = nullptr;
+      if (TimePassesIsEnabled) {
+        PartitionTimer = &PartitionTimers[ThreadCount];
+        PartitionTimer->init("Partition " + utostr(ThreadCount) + " (" +
+                                 utostr(getInstructionCount(*MPart)) +
+                                 " instructions)",
+                             CodegenTimerGroup);
+      }
 
-  for (thread &T : Threads)
-    T.join();
+      llvm::raw_pwrite_stream *ThreadOS = OSs[ThreadCount++];
+      CodegenThreadPool.async(
+          [TheTarget, CPU, Features, Options, RM, CM, OL, FileType, ThreadOS,
+           PartitionTimer](const SmallVector<char, 0> &BC) {
+            TimeRegion PartitionRegion(PartitionTimer);
+            LLVMContext Ctx;
+            ErrorOr<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+                MemoryBufferRef(StringRef(BC.data(), BC.size()),
+                                "<split-module>"),
+                Ctx);
+            if (!MOrErr)
+              report_fatal_error("Failed to read bitcode");
+            std::unique_ptr<Module> MPartInCtx = std::move(MOrErr.get());
+
+            codegen(MPartInCtx.get(), *ThreadOS, TheTarget, CPU, Features,
+                    Options, RM, CM, OL, FileType);
+          },
+          // Pass BC using std::move to ensure that it get moved rather than
+          // copied into the thread's context.
+          std::move(BC));
+    }, /*PreserveLocals=*/true);
+  }
 
   return {};
 }
@@ -54,6 +54,8 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumGrowRegionBailouts,
+          "Number of region splits given up on for compile time");
 
 static cl::opt<SplitEditor::ComplementSpillMode>
 SplitSpillMode("split-spill-mode", cl::Hidden,
@@ -94,6 +96,14 @@ static cl::opt<bool> EnableDeferredSpilling(
              "variable because of other evicted variables."),
     cl::init(false));
 
+// growRegion() does not scale with the number of edge bundles, so bound the
+// number of blocks it may visit for a single split candidate, and give up on
+// the candidate once the budget is exceeded.
+static cl::opt<unsigned> GrowRegionComplexityBudget(
+    "grow-region-complexity-budget", cl::Hidden,
+    cl::desc("Maximum number of blocks growRegion() may visit per candidate"),
+    cl::init(10000));
+
 // FIXME: Find a good default for this flag and remove the flag.
 static cl::opt<unsigned>
 CSRFirstTimeCost("regalloc-csr-first-time-cost",
@@ -347,7 +357,7 @@ private:
   BlockFrequency calcSpillCost();
   bool addSplitConstraints(InterferenceCache::Cursor, BlockFrequency&);
   void addThroughConstraints(InterferenceCache::Cursor, ArrayRef<unsigned>);
-  void growRegion(GlobalSplitCandidate &Cand);
+  bool growRegion(GlobalSplitCandidate &Cand);
   BlockFrequency calcGlobalSplitCost(GlobalSplitCandidate&);
   bool calcCompactRegion(GlobalSplitCandidate&);
   void splitAroundRegion(LiveRangeEdit&, ArrayRef<unsigned>);
@@ -1033,11 +1043,15 @@ void RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
   SpillPlacer->addLinks(makeArrayRef(TBS, T));
 }
 
-void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
+/// growRegion - Add the live-through blocks connected to the bundles the spill
+/// placer currently wants in a register to Cand, until nothing changes.
+/// Returns false if this would visit more blocks than the complexity budget.
+bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
   // Keep track of through blocks that have not been added to SpillPlacer.
   BitVector Todo = SA->getThroughBlocks();
   SmallVectorImpl<unsigned> &ActiveBlocks = Cand.ActiveBlocks;
   unsigned AddedTo = 0;
+  unsigned Budget = GrowRegionComplexityBudget;
 #ifndef NDEBUG
   unsigned Visited = 0;
 #endif
@@ -1049,6 +1063,13 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
       unsigned Bundle = NewBundles[i];
       // Look at all blocks connected to Bundle in the full graph.
       ArrayRef<unsigned> Blocks = Bundles->getBlocks(Bundle);
+      // Bound compile time on huge functions.
+      if (Blocks.size() >= Budget) {
+        ++NumGrowRegionBailouts;
+        DEBUG(dbgs() << ", budget exceeded");
+        return false;
+      }
+      Budget -= Blocks.size();
       for (ArrayRef<unsigned>::iterator I = Blocks.begin(), E = Blocks.end();
            I != E; ++I) {
         unsigned Block = *I;
@@ -1081,6 +1102,7 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
     SpillPlacer->iterate();
   }
   DEBUG(dbgs() << ", v=" << Visited);
+  return true;
 }
 
 /// calcCompactRegion - Compute the set of edge bundles that should be live
@@ -1111,7 +1133,10 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
     return false;
   }
 
-  growRegion(Cand);
+  if (!growRegion(Cand)) {
+    DEBUG(dbgs() << ", cannot grow region.\n");
+    return false;
+  }
   SpillPlacer->finish();
 
   if (!Cand.LiveBundles.any()) {
@@ -1424,7 +1449,10 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
       });
       continue;
     }
-    growRegion(Cand);
+    if (!growRegion(Cand)) {
+      DEBUG(dbgs() << ", cannot grow region.\n");
+      continue;
+    }
 
     SpillPlacer->finish();
 
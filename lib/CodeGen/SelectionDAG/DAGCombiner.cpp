@@ -21,6 +21,7 @@
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
@@ -48,6 +49,8 @@ STATISTIC(PostIndexedNodes, "Number of post-indexed nodes created");
 STATISTIC(OpsNarrowed     , "Number of load/op/store narrowed");
 STATISTIC(LdStFP2Int      , "Number of fp load/store pairs transformed to int");
 STATISTIC(SlicedLoads, "Number of load sliced");
+STATISTIC(NodeLimitSkips, "Number of combines skipped by the per-node limit");
+STATISTIC(DAGLimitSkips, "Number of combines skipped by the per-DAG limit");
 
 namespace {
   static cl::opt<bool>
@@ -81,6 +84,24 @@ namespace {
     MaySplitLoadIndex("combiner-split-load-index", cl::Hidden, cl::init(true),
                       cl::desc("DAG combiner may split indexing from loads"));
 
+  /// Hidden options to bound the time spent combining pathological DAGs.
+  /// Once a limit is reached, the nodes still on the worklist are only
+  /// deleted when dead and, after legalization, legalized.
+  static cl::opt<unsigned>
+    CombinerNodeLimit("combiner-node-limit", cl::Hidden, cl::init(0),
+                      cl::desc("Maximum number of times the DAG combiner "
+                               "tries to combine a node (0 = unlimited)"));
+
+  static cl::opt<unsigned>
+    CombinerDAGLimit("combiner-dag-limit", cl::Hidden, cl::init(0),
+                     cl::desc("Maximum number of combines the DAG combiner "
+                              "attempts per run (0 = unlimited)"));
+
+  static cl::opt<bool>
+    PrintCombineCounts("combiner-print-counts", cl::Hidden,
+                       cl::desc("Print how often each node kind was combined "
+                                "by each run of the DAG combiner"));
+
 //------------------------------ DAGCombiner ---------------------------------//
 
   class DAGCombiner {
@@ -114,6 +135,15 @@ namespace {
     /// which have not yet been combined to the worklist.
     SmallPtrSet<SDNode *, 64> CombinedNodes;
 
+    /// \brief Number of times each node was handed to combine() in this run.
+    ///
+    /// Only maintained when CombinerNodeLimit is set.
+    DenseMap<SDNode *, unsigned> CombineAttempts;
+
+    /// \brief Number of combines attempted and performed in this run, for each
+    /// kind of node. Only maintained when PrintCombineCounts is set.
+    StringMap<std::pair<unsigned, unsigned>> CombineCounts;
+
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis &AA;
 
@@ -143,6 +173,8 @@ namespace {
     /// Remove all instances of N from the worklist.
     void removeFromWorklist(SDNode *N) {
       CombinedNodes.erase(N);
+      // The memory of N may be reused for a new node.
+      CombineAttempts.erase(N);
 
       auto It = WorklistMap.find(N);
       if (It == WorklistMap.end())
@@ -467,6 +499,13 @@ namespace {
     /// Runs the dag combiner on all nodes in the work list
     void Run(CombineLevel AtLevel);
 
+    /// Check whether the combine limits allow another attempt at combining N,
+    /// and account for it.
+    bool mayCombine(SDNode *N, unsigned &DAGAttempts);
+
+    /// Print the combine counts of the last run to errs().
+    void printCombineCounts() const;
+
     SelectionDAG &getDAG() const { return DAG; }
 
     /// Returns a type large enough to hold any valid shift amount - before type
@@ -1244,6 +1283,61 @@ bool DAGCombiner::recursivelyDeleteUnusedNodes(SDNode *N) {
 //  Main DAG Combiner implementation
 //===----------------------------------------------------------------------===//
 
+bool DAGCombiner::mayCombine(SDNode *N, unsigned &DAGAttempts) {
+  if (CombinerDAGLimit && DAGAttempts >= CombinerDAGLimit) {
+    ++DAGLimitSkips;
+    return false;
+  }
+  if (CombinerNodeLimit && ++CombineAttempts[N] > CombinerNodeLimit) {
+    ++NodeLimitSkips;
+    return false;
+  }
+  ++DAGAttempts;
+  return true;
+}
+
+static const char *getCombineLevelName(CombineLevel Level) {
+  switch (Level) {
+  case BeforeLegalizeTypes:
+    return "before type legalization";
+  case AfterLegalizeTypes:
+    return "after type legalization";
+  case AfterLegalizeVectorOps:
+    return "after vector op legalization";
+  case AfterLegalizeDAG:
+    return "after DAG legalization";
+  }
+  llvm_unreachable("Unknown combine level!");
+}
+
+void DAGCombiner::printCombineCounts() const {
+  typedef std::pair<StringRef, std::pair<unsigned, unsigned>> CountTy;
+  std::vector<CountTy> Counts;
+  unsigned Attempted = 0, Fired = 0;
+  for (const auto &Entry : CombineCounts) {
+    Counts.push_back(CountTy(Entry.getKey(), Entry.getValue()));
+    Attempted += Entry.getValue().first;
+    Fired += Entry.getValue().second;
+  }
+
+  // Most often combined first.
+  std::sort(Counts.begin(), Counts.end(),
+            [](const CountTy &A, const CountTy &B) {
+    if (A.second.second != B.second.second)
+      return A.second.second > B.second.second;
+    if (A.second.first != B.second.first)
+      return A.second.first > B.second.first;
+    return A.first < B.first;
+  });
+
+  errs() << "DAG combines in '" << DAG.getMachineFunction().getName() << "' "
+         << getCombineLevelName(Level) << ": " << Attempted << " attempted, "
+         << Fired << " fired\n";
+  for (const CountTy &C : Counts)
+    errs() << "  " << C.first << ": " << C.second.first << " attempted, "
+           << C.second.second << " fired\n";
+}
+
 void DAGCombiner::Run(CombineLevel AtLevel) {
   // set the instance variables, so that the various visit routines may use it.
   Level = AtLevel;
@@ -1259,6 +1353,10 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
   // changes of the root.
   HandleSDNode Dummy(DAG.getRoot());
 
+  CombineAttempts.clear();
+  CombineCounts.clear();
+  unsigned DAGAttempts = 0;
+
   // while the worklist isn't empty, find a node and
   // try and combine it.
   while (!WorklistMap.empty()) {
@@ -1305,12 +1403,23 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
       if (!CombinedNodes.count(ChildN.getNode()))
         AddToWorklist(ChildN.getNode());
 
+    if (!mayCombine(N, DAGAttempts))
+      continue;
+
+    std::pair<unsigned, unsigned> *Counts = nullptr;
+    if (PrintCombineCounts) {
+      Counts = &CombineCounts[N->getOperationName(&DAG)];
+      ++Counts->first;
+    }
+
     SDValue RV = combine(N);
 
     if (!RV.getNode())
       continue;
 
     ++NodesCombined;
+    if (Counts)
+      ++Counts->second;
 
     // If we get back the same node we passed in, rather than a new node or
     // zero, we know that the node must have defined multiple values and
@@ -1351,6 +1460,9 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
   // If the root changed (e.g. it was a dead load, update the root).
   DAG.setRoot(Dummy.getValue());
   DAG.RemoveDeadNodes();
+
+  if (PrintCombineCounts)
+    printCombineCounts();
 }
 
 SDValue DAGCombiner::visit(SDNode *N) {
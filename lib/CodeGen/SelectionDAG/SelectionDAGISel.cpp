@@ -69,6 +69,8 @@ STATISTIC(NumFastIselBlocks, "Number of blocks selected entirely by fast isel");
 STATISTIC(NumDAGBlocks, "Number of blocks selected using DAG");
 STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
 STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
+STATISTIC(NumSwitchCacheHits,
+          "Number of nested opcode switches dispatched through the cache");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
 
@@ -178,6 +180,16 @@ static cl::opt<int> EnableFastISelAbort(
              "abort for argument lowering, and 3 will never fallback "
              "to SelectionDAG."));
 
+static cl::opt<bool>
+DisableSwitchCaseCache("disable-isel-switch-cache", cl::Hidden,
+          cl::desc("Dispatch nested opcode switches of the isel state machine "
+                   "by scanning their cases"));
+
+// Nested opcode switches in which finding the matching case meant skipping at
+// least this many cases are marked as large. From then on, every case lookup
+// of a large switch goes through SwitchCaseCache.
+static const unsigned SwitchCaseCacheMinSkipped = 4;
+
 static cl::opt<bool>
 UseMBPI("use-mbpi",
         cl::desc("use Machine Branch Probability Info"),
@@ -2870,7 +2882,31 @@ SelectCodeCommon(SDNode *NodeToMatch, const unsigned char *MatcherTable,
     case OPC_SwitchOpcode: {
       unsigned CurNodeOpcode = N.getOpcode();
       unsigned SwitchStart = MatcherIndex-1; (void)SwitchStart;
+
+      // Large switches are only scanned the first time they see an opcode.
+      // Small ones, which are most of them, only cost a bit test here.
+      uint64_t CacheKey = (uint64_t)SwitchStart << 32 | CurNodeOpcode;
+      bool IsLarge = false;
+      if (!DisableSwitchCaseCache) {
+        if (LargeSwitches.size() < TableSize)
+          LargeSwitches.resize(TableSize);
+        IsLarge = LargeSwitches.test(SwitchStart);
+      }
+      if (IsLarge) {
+        auto Cached = SwitchCaseCache.find(CacheKey);
+        if (Cached != SwitchCaseCache.end()) {
+          ++NumSwitchCacheHits;
+          // If no cases matched, bail out.
+          if (!Cached->second) break;
+          MatcherIndex = Cached->second;
+          DEBUG(dbgs() << "  OpcodeSwitch from " << SwitchStart
+                       << " to " << MatcherIndex << " (cached)\n");
+          continue;
+        }
+      }
+
       unsigned CaseSize;
+      unsigned NumSkipped = 0;
       while (1) {
         // Get the size of this case.
         CaseSize = MatcherTable[MatcherIndex++];
@@ -2887,6 +2923,13 @@ SelectCodeCommon(SDNode *NodeToMatch, const unsigned char *MatcherTable,
 
         // Otherwise, skip over this case.
         MatcherIndex += CaseSize;
+        ++NumSkipped;
+      }
+
+      if (!DisableSwitchCaseCache &&
+          (IsLarge || NumSkipped >= SwitchCaseCacheMinSkipped)) {
+        LargeSwitches.set(SwitchStart);
+        SwitchCaseCache[CacheKey] = CaseSize ? MatcherIndex : 0;
       }
 
       // If no cases matched, bail out.
@@ -336,7 +336,7 @@ const DWARFDebugAranges *DWARFContext::getDebugAranges() {
     return Aranges.get();
 
   Aranges.reset(new DWARFDebugAranges());
-  Aranges->generate(this);
+  Aranges->generate(this, ThreadCount);
   return Aranges.get();
 }
 
@@ -12,6 +12,8 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -35,7 +37,7 @@ void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   }
 }
 
-void DWARFDebugAranges::generate(DWARFContext *CTX) {
+void DWARFDebugAranges::generate(DWARFContext *CTX, unsigned ThreadCount) {
   clear();
   if (!CTX)
     return;
@@ -47,15 +49,34 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
-  for (const auto &CU : CTX->compile_units()) {
-    uint32_t CUOffset = CU->getOffset();
-    if (ParsedCUOffsets.insert(CUOffset).second) {
-      DWARFAddressRangesVector CURanges;
-      CU->collectAddressRanges(CURanges);
-      for (const auto &R : CURanges) {
-        appendRange(CUOffset, R.first, R.second);
-      }
-    }
+  std::vector<DWARFCompileUnit *> CUs;
+  for (const auto &CU : CTX->compile_units())
+    if (ParsedCUOffsets.insert(CU->getOffset()).second)
+      CUs.push_back(CU.get());
+
+  // Walking the DIEs of a unit only touches that unit, so the units can be
+  // walked in parallel. The ranges are appended in unit order afterwards, so
+  // that the result does not depend on the scheduling.
+  std::vector<DWARFAddressRangesVector> CURanges(CUs.size());
+  if (!llvm_is_multithreaded())
+    ThreadCount = 1;
+  ThreadCount = std::min<unsigned>(ThreadCount, CUs.size());
+  if (ThreadCount > 1) {
+    ThreadPool Pool(ThreadCount);
+    for (unsigned I = 0, E = CUs.size(); I != E; ++I)
+      Pool.async([&CUs, &CURanges, I] {
+        CUs[I]->collectAddressRanges(CURanges[I]);
+      });
+    Pool.wait();
+  } else {
+    for (unsigned I = 0, E = CUs.size(); I != E; ++I)
+      CUs[I]->collectAddressRanges(CURanges[I]);
+  }
+
+  for (unsigned I = 0, E = CUs.size(); I != E; ++I) {
+    uint32_t CUOffset = CUs[I]->getOffset();
+    for (const auto &R : CURanges[I])
+      appendRange(CUOffset, R.first, R.second);
   }
 
   construct();
@@ -110,8 +110,8 @@ ErrorOr<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
 
 void LLVMSymbolizer::flush() {
   Modules.clear();
-  ObjectPairForPathArch.clear();
-  ObjectFileForArch.clear();
+  ModuleLRU.clear();
+  CacheSize = 0;
 }
 
 // For Path="/path/to/foo" and Basename="foo" assume that debug info is in
@@ -214,7 +214,8 @@ bool darwinDsymMatchesBinary(const MachOObjectFile *DbgObj,
 }
 
 ObjectFile *LLVMSymbolizer::lookUpDsymFile(const std::string &ExePath,
-    const MachOObjectFile *MachExeObj, const std::string &ArchName) {
+    const MachOObjectFile *MachExeObj, const std::string &ArchName,
+    OwnedBinaries &Owner) {
   // On Darwin we may find DWARF in separate object file in
   // resource directory.
   std::vector<std::string> DsymPaths;
@@ -228,7 +229,7 @@ ObjectFile *LLVMSymbolizer::lookUpDsymFile(const std::string &ExePath,
     if (!BinaryOrErr)
       continue;
     OwningBinary<Binary> &B = BinaryOrErr.get();
-    auto DbgObjOrErr = getObjectFileFromBinary(B.getBinary(), ArchName);
+    auto DbgObjOrErr = getObjectFileFromBinary(B.getBinary(), ArchName, Owner);
     if (!DbgObjOrErr)
       continue;
     ObjectFile *DbgObj = DbgObjOrErr.get();
@@ -237,7 +238,7 @@ ObjectFile *LLVMSymbolizer::lookUpDsymFile(const std::string &ExePath,
     if (!MachDbgObj)
       continue;
     if (darwinDsymMatchesBinary(MachDbgObj, MachExeObj)) {
-      addOwningBinary(std::move(B));
+      Owner.addOwningBinary(std::move(B));
       return DbgObj;
     }
   }
@@ -246,7 +247,8 @@ ObjectFile *LLVMSymbolizer::lookUpDsymFile(const std::string &ExePath,
 
 ObjectFile *LLVMSymbolizer::lookUpDebuglinkObject(const std::string &Path,
                                                   const ObjectFile *Obj,
-                                                  const std::string &ArchName) {
+                                                  const std::string &ArchName,
+                                                  OwnedBinaries &Owner) {
   std::string DebuglinkName;
   uint32_t CRCHash;
   std::string DebugBinaryPath;
@@ -259,71 +261,52 @@ ObjectFile *LLVMSymbolizer::lookUpDebuglinkObject(const std::string &Path,
   if (!DebugBinaryOrErr)
     return nullptr;
   OwningBinary<Binary> &DB = DebugBinaryOrErr.get();
-  auto DbgObjOrErr = getObjectFileFromBinary(DB.getBinary(), ArchName);
+  auto DbgObjOrErr = getObjectFileFromBinary(DB.getBinary(), ArchName, Owner);
   if (!DbgObjOrErr)
     return nullptr;
-  addOwningBinary(std::move(DB));
+  Owner.addOwningBinary(std::move(DB));
   return DbgObjOrErr.get();
 }
 
 ErrorOr<LLVMSymbolizer::ObjectPair>
-LLVMSymbolizer::getOrCreateObjects(const std::string &Path,
-                                   const std::string &ArchName) {
-  const auto &I = ObjectPairForPathArch.find(std::make_pair(Path, ArchName));
-  if (I != ObjectPairForPathArch.end())
-    return I->second;
-
+LLVMSymbolizer::createObjects(const std::string &Path,
+                              const std::string &ArchName,
+                              OwnedBinaries &Owner) {
   ErrorOr<OwningBinary<Binary>> BinaryOrErr = createBinary(Path);
-  if (auto EC = BinaryOrErr.getError()) {
-    ObjectPairForPathArch.insert(
-        std::make_pair(std::make_pair(Path, ArchName), EC));
+  if (auto EC = BinaryOrErr.getError())
     return EC;
-  }
   OwningBinary<Binary> &B = BinaryOrErr.get();
 
-  auto ObjOrErr = getObjectFileFromBinary(B.getBinary(), ArchName);
-  if (auto EC = ObjOrErr.getError()) {
-    ObjectPairForPathArch.insert(
-        std::make_pair(std::make_pair(Path, ArchName), EC));
+  auto ObjOrErr = getObjectFileFromBinary(B.getBinary(), ArchName, Owner);
+  if (auto EC = ObjOrErr.getError())
     return EC;
-  }
-  addOwningBinary(std::move(B));
+  Owner.addOwningBinary(std::move(B));
 
   ObjectFile *Obj = ObjOrErr.get();
   assert(Obj != nullptr);
   ObjectFile *DbgObj = nullptr;
 
   if (auto MachObj = dyn_cast<const MachOObjectFile>(Obj))
-    DbgObj = lookUpDsymFile(Path, MachObj, ArchName);
+    DbgObj = lookUpDsymFile(Path, MachObj, ArchName, Owner);
   if (!DbgObj)
-    DbgObj = lookUpDebuglinkObject(Path, Obj, ArchName);
+    DbgObj = lookUpDebuglinkObject(Path, Obj, ArchName, Owner);
   if (!DbgObj)
     DbgObj = Obj;
-  ObjectPair Res = std::make_pair(Obj, DbgObj);
-  ObjectPairForPathArch.insert(
-      std::make_pair(std::make_pair(Path, ArchName), Res));
-  return Res;
+  return std::make_pair(Obj, DbgObj);
 }
 
 ErrorOr<ObjectFile *>
 LLVMSymbolizer::getObjectFileFromBinary(Binary *Bin,
-                                        const std::string &ArchName) {
+                                        const std::string &ArchName,
+                                        OwnedBinaries &Owner) {
   assert(Bin != nullptr);
   if (MachOUniversalBinary *UB = dyn_cast<MachOUniversalBinary>(Bin)) {
-    const auto &I = ObjectFileForArch.find(
-        std::make_pair(UB, ArchName));
-    if (I != ObjectFileForArch.end())
-      return I->second;
     ErrorOr<std::unique_ptr<ObjectFile>> ParsedObj =
         UB->getObjectForArch(ArchName);
-    if (auto EC = ParsedObj.getError()) {
-      ObjectFileForArch.insert(
-          std::make_pair(std::make_pair(UB, ArchName), EC));
+    if (auto EC = ParsedObj.getError())
       return EC;
-    }
     ObjectFile *Res = ParsedObj.get().get();
-    ParsedBinariesAndObjects.push_back(std::move(ParsedObj.get()));
-    ObjectFileForArch.insert(std::make_pair(std::make_pair(UB, ArchName), Res));
+    Owner.Binaries.push_back(std::move(ParsedObj.get()));
     return Res;
   }
   if (Bin->isObject()) {
@@ -336,7 +319,8 @@ ErrorOr<SymbolizableModule *>
 LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   const auto &I = Modules.find(ModuleName);
   if (I != Modules.end()) {
-    auto &InfoOrErr = I->second;
+    ModuleLRU.splice(ModuleLRU.begin(), ModuleLRU, I->second.LRUPos);
+    auto &InfoOrErr = I->second.Info;
     if (auto EC = InfoOrErr.getError())
       return EC;
     return InfoOrErr->get();
@@ -352,11 +336,11 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       ArchName = ArchStr;
     }
   }
-  auto ObjectsOrErr = getOrCreateObjects(BinaryName, ArchName);
+  OwnedBinaries Owner;
+  auto ObjectsOrErr = createObjects(BinaryName, ArchName, Owner);
   if (auto EC = ObjectsOrErr.getError()) {
     // Failed to find valid object file.
-    Modules.insert(std::make_pair(ModuleName, EC));
-    return EC;
+    return addModule(ModuleName, std::move(Owner), EC, 0);
   }
   ObjectPair Objects = ObjectsOrErr.get();
 
@@ -371,17 +355,54 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       Context.reset(new PDBContext(*CoffObject, std::move(Session)));
     }
   }
-  if (!Context)
-    Context.reset(new DWARFContextInMemory(*Objects.second));
+  if (!Context) {
+    auto DICtx = llvm::make_unique<DWARFContextInMemory>(*Objects.second);
+    DICtx->setThreadCount(Opts.ThreadCount);
+    Context = std::move(DICtx);
+  }
   assert(Context);
   auto InfoOrErr =
       SymbolizableObjectFile::create(Objects.first, std::move(Context));
-  auto InsertResult =
-      Modules.insert(std::make_pair(ModuleName, std::move(InfoOrErr)));
+  if (auto EC = InfoOrErr.getError())
+    return addModule(ModuleName, std::move(Owner), EC, 0);
+
+  // Most of the memory of a module goes to the debug information parsed from
+  // the object holding it, so charge the module for the size of that object.
+  uint64_t Size = Objects.second->getData().size();
+  return addModule(ModuleName, std::move(Owner), std::move(InfoOrErr), Size);
+}
+
+ErrorOr<SymbolizableModule *>
+LLVMSymbolizer::addModule(const std::string &ModuleName, OwnedBinaries Owner,
+                          ErrorOr<std::unique_ptr<SymbolizableModule>> Info,
+                          uint64_t Size) {
+  // Charge every module for its name too, so that modules which failed to load
+  // count against the budget and are evicted as well.
+  Size += ModuleName.size();
+  ModuleLRU.push_front(ModuleName);
+  auto InsertResult = Modules.insert(std::make_pair(
+      ModuleName, CachedModule(std::move(Owner), std::move(Info), Size,
+                               ModuleLRU.begin())));
   assert(InsertResult.second);
-  if (auto EC = InsertResult.first->second.getError())
+  CacheSize += Size;
+  ErrorOr<std::unique_ptr<SymbolizableModule>> &InfoOrErr =
+      InsertResult.first->second.Info;
+  pruneCache();
+  if (auto EC = InfoOrErr.getError())
     return EC;
-  return InsertResult.first->second->get();
+  return InfoOrErr->get();
+}
+
+void LLVMSymbolizer::pruneCache() {
+  if (!Opts.MaxCacheSize)
+    return;
+  while (CacheSize > Opts.MaxCacheSize && ModuleLRU.size() > 1) {
+    auto I = Modules.find(ModuleLRU.back());
+    assert(I != Modules.end());
+    CacheSize -= I->second.Size;
+    Modules.erase(I);
+    ModuleLRU.pop_back();
+  }
 }
 
 // Undo these various manglings for Win32 extern "C" functions:
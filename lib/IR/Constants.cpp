@@ -2886,35 +2886,28 @@ Value *ConstantStruct::handleOperandChangeImpl(Value *From, Value *To, Use *U) {
   Constant *ToC = cast<Constant>(To);
 
   Use *OperandList = getOperandList();
-  unsigned OperandToUpdate = U-OperandList;
-  assert(getOperand(OperandToUpdate) == From && "ReplaceAllUsesWith broken!");
 
   SmallVector<Constant*, 8> Values;
   Values.reserve(getNumOperands());  // Build replacement struct.
 
-  // Fill values with the modified operands of the constant struct.  Also,
-  // compute whether this turns into an all-zeros struct.
-  bool isAllZeros = false;
-  bool isAllUndef = false;
-  if (ToC->isNullValue()) {
-    isAllZeros = true;
-    for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
-      Constant *Val = cast<Constant>(O->get());
-      Values.push_back(Val);
-      if (isAllZeros) isAllZeros = Val->isNullValue();
-    }
-  } else if (isa<UndefValue>(ToC)) {
-    isAllUndef = true;
-    for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
-      Constant *Val = cast<Constant>(O->get());
-      Values.push_back(Val);
-      if (isAllUndef) isAllUndef = isa<UndefValue>(Val);
+  // Fill values with the modified operands of the constant struct.  Like
+  // ConstantArray, replace every use of From at once so that a struct using
+  // From many times is only re-uniqued once.  Also compute whether this turns
+  // into an all-zeros or all-undef struct.
+  unsigned NumUpdated = 0;
+  bool isAllZeros = ToC->isNullValue();
+  bool isAllUndef = isa<UndefValue>(ToC);
+  for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
+    Constant *Val = cast<Constant>(O->get());
+    if (Val == From) {
+      Val = ToC;
+      ++NumUpdated;
     }
-  } else {
-    for (Use *O = OperandList, *E = OperandList + getNumOperands(); O != E; ++O)
-      Values.push_back(cast<Constant>(O->get()));
+    Values.push_back(Val);
+    if (isAllZeros) isAllZeros = Val->isNullValue();
+    if (isAllUndef) isAllUndef = isa<UndefValue>(Val);
   }
-  Values[OperandToUpdate] = ToC;
+  assert(NumUpdated && "ReplaceAllUsesWith broken!");
 
   if (isAllZeros)
     return ConstantAggregateZero::get(getType());
@@ -2924,7 +2917,7 @@ Value *ConstantStruct::handleOperandChangeImpl(Value *From, Value *To, Use *U) {
 
   // Update to the new value.
   return getContext().pImpl->StructConstants.replaceOperandsInPlace(
-      Values, this, From, ToC);
+      Values, this, From, ToC, NumUpdated, U - OperandList);
 }
 
 Value *ConstantVector::handleOperandChangeImpl(Value *From, Value *To, Use *U) {
@@ -323,6 +323,14 @@ void Function::dropAllReferences() {
   for (iterator I = begin(), E = end(); I != E; ++I)
     I->dropAllReferences();
 
+  // Delete the instructions while their blocks are still in the function, so
+  // that removing them from the symbol table and deleting them is a single
+  // walk over each block. Unlinking a non-empty block would first walk it to
+  // move the instruction names out of the symbol table, and its destructor
+  // would walk it again to drop references that are already gone.
+  for (BasicBlock &BB : *this)
+    BB.getInstList().clear();
+
   // Delete all basic blocks. They are now unused, except possibly by
   // blockaddresses, but BasicBlock's destructor takes care of those.
   while (!BasicBlocks.empty())
@@ -0,0 +1,134 @@
+//===-LTOObjectCache.cpp - On-disk cache of LTO backend outputs -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the LTOObjectCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/LTO/LTOObjectCache.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#ifdef HAVE_LLVM_REVISION_INC
+#include "LLVMRevision.inc"
+#endif
+
+using namespace llvm;
+
+LTOObjectCache::LTOObjectCache(StringRef CacheDir) : CacheDir(CacheDir) {
+  sys::fs::create_directories(CacheDir);
+}
+
+SmallString<128> LTOObjectCache::getEntryPath(StringRef Key) const {
+  SmallString<128> EntryPath(CacheDir);
+  sys::path::append(EntryPath, "llvmcache-" + Key);
+  return EntryPath;
+}
+
+std::string LTOObjectCache::computeKey(const Module &M, StringRef Options) {
+  SmallVector<char, 0> Bitcode;
+  raw_svector_ostream OS(Bitcode);
+  WriteBitcodeToFile(&M, OS);
+
+  // Terminate every variable length field, so that different splits of the
+  // same bytes between two fields do not hash to the same key.
+  MD5 Hasher;
+  auto AddField = [&Hasher](StringRef Field) {
+    Hasher.update(Field);
+    Hasher.update(StringRef("", 1));
+  };
+  AddField(LLVM_VERSION_STRING);
+#ifdef LLVM_REVISION
+  // Development builds share a version string, tell them apart.
+  AddField(LLVM_REVISION);
+#endif
+  AddField(M.getTargetTriple());
+  AddField(Options);
+  Hasher.update(ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(Bitcode.data()), Bitcode.size()));
+
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  SmallString<32> Key;
+  MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
+std::unique_ptr<MemoryBuffer> LTOObjectCache::lookup(StringRef Key) const {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> ObjectOrErr =
+      MemoryBuffer::getFile(getEntryPath(Key), -1,
+                            /*RequiresNullTerminator=*/false);
+  if (!ObjectOrErr)
+    return nullptr;
+  return std::move(*ObjectOrErr);
+}
+
+void LTOObjectCache::store(StringRef Key, StringRef Object) const {
+  SmallString<128> EntryPath = getEntryPath(Key);
+
+  // Write the object to a temporary file first, so that concurrent readers
+  // never observe a partially written entry.
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(Twine(EntryPath) + ".tmp%%%%%%", FD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Object;
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  if (sys::fs::rename(TempPath, EntryPath))
+    sys::fs::remove(TempPath);
+}
+
+std::unique_ptr<MemoryBuffer> LTOObjectCache::getOrGenerate(
+    StringRef Key,
+    function_ref<std::unique_ptr<MemoryBuffer>()> Generate) const {
+  SmallString<128> EntryPath = getEntryPath(Key);
+  while (true) {
+    if (std::unique_ptr<MemoryBuffer> Object = lookup(Key))
+      return Object;
+
+    LockFileManager Lock(EntryPath);
+    switch (Lock) {
+    case LockFileManager::LFS_Error:
+      // The cache directory cannot be used, generate the object uncached.
+      return Generate();
+
+    case LockFileManager::LFS_Owned: {
+      // Another process may have published the entry after our lookup and
+      // before we took the lock.
+      if (std::unique_ptr<MemoryBuffer> Object = lookup(Key))
+        return Object;
+      std::unique_ptr<MemoryBuffer> Object = Generate();
+      if (Object)
+        store(Key, Object->getBuffer());
+      return Object;
+    }
+
+    case LockFileManager::LFS_Shared:
+      // Someone else is generating the entry: wait for them and look it up
+      // again. If they gave up or died, the next iteration generates it here.
+      if (Lock.waitForUnlock() == LockFileManager::Res_Timeout)
+        Lock.unsafeRemoveLockFile();
+      break;
+    }
+  }
+}
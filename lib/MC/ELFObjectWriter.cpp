@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/MC/MCELFObjectWriter.h"
+#include "llvm/ADT/CachedHashString.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
@@ -34,6 +35,8 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include <vector>
 using namespace llvm;
 
@@ -79,7 +82,9 @@ class ELFObjectWriter : public MCObjectWriter {
     struct ELFSymbolData {
       const MCSymbolELF *Symbol;
       uint32_t SectionIndex;
-      StringRef Name;
+      // Hashed once, as it is used for both adding to and looking up in the
+      // string table.
+      CachedHashStringRef Name{StringRef()};
 
       // Support lexicographic sorting.
       bool operator<(const ELFSymbolData &RHS) const {
@@ -91,7 +96,7 @@ class ELFObjectWriter : public MCObjectWriter {
           return true;
         if (LHSType == ELF::STT_SECTION && RHSType == ELF::STT_SECTION)
           return SectionIndex < RHS.SectionIndex;
-        return Name < RHS.Name;
+        return Name.val() < RHS.Name.val();
       }
     };
 
@@ -158,13 +163,15 @@ class ELFObjectWriter : public MCObjectWriter {
         write32(W);
     }
 
-    template <typename T> void write(T Val) {
+    template <typename T> void write(raw_ostream &OS, T Val) const {
       if (IsLittleEndian)
-        support::endian::Writer<support::little>(getStream()).write(Val);
+        support::endian::Writer<support::little>(OS).write(Val);
       else
-        support::endian::Writer<support::big>(getStream()).write(Val);
+        support::endian::Writer<support::big>(OS).write(Val);
     }
 
+    template <typename T> void write(T Val) { write(getStream(), Val); }
+
     void writeHeader(const MCAssembler &Asm);
 
     void writeSymbol(SymbolTableWriter &Writer, uint32_t StringIndex,
@@ -217,7 +224,18 @@ class ELFObjectWriter : public MCObjectWriter {
                           uint32_t Link, uint32_t Info, uint64_t Alignment,
                           uint64_t EntrySize);
 
-    void writeRelocations(const MCAssembler &Asm, const MCSectionELF &Sec);
+    /// Sort \p Relocs, the relocations of a section, and append their
+    /// encoding to \p Out.
+    void encodeRelocations(const MCAssembler &Asm,
+                           std::vector<ELFRelocationEntry> &Relocs,
+                           SmallVectorImpl<char> &Out) const;
+
+    /// Encode the contents of every section in \p RelSections into the
+    /// matching element of \p Out. When there are many of them, they are
+    /// encoded on up to Asm.getThreadCount() threads.
+    void encodeRelocationSections(const MCAssembler &Asm,
+                                  ArrayRef<MCSectionELF *> RelSections,
+                                  MutableArrayRef<SmallVector<char, 0>> Out);
 
     bool isSymbolRefDifferenceFullyResolvedImpl(const MCAssembler &Asm,
                                                 const MCSymbol &SymA,
@@ -866,8 +884,8 @@ void ELFObjectWriter::computeSymbolTable(
 
     // Sections have their own string table
     if (Symbol.getType() != ELF::STT_SECTION) {
-      MSD.Name = Name;
-      StrTabBuilder.add(Name);
+      MSD.Name = CachedHashStringRef(Name);
+      StrTabBuilder.add(MSD.Name);
     }
 
     if (Local)
@@ -890,7 +908,7 @@ void ELFObjectWriter::computeSymbolTable(
   for (const std::string &Name : FileNames)
     StrTabBuilder.add(Name);
 
-  StrTabBuilder.finalize();
+  StrTabBuilder.finalize(Asm.getThreadCount());
 
   for (const std::string &Name : FileNames)
     Writer.writeSymbol(StrTabBuilder.getOffset(Name),
@@ -1046,47 +1064,90 @@ void ELFObjectWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type,
   WriteWord(EntrySize); // sh_entsize
 }
 
-void ELFObjectWriter::writeRelocations(const MCAssembler &Asm,
-                                       const MCSectionELF &Sec) {
-  std::vector<ELFRelocationEntry> &Relocs = Relocations[&Sec];
-
+void ELFObjectWriter::encodeRelocations(
+    const MCAssembler &Asm, std::vector<ELFRelocationEntry> &Relocs,
+    SmallVectorImpl<char> &Out) const {
   // Sort the relocation entries. Most targets just sort by Offset, but some
   // (e.g., MIPS) have additional constraints.
   TargetObjectWriter->sortRelocs(Asm, Relocs);
 
+  raw_svector_ostream OS(Out);
   for (unsigned i = 0, e = Relocs.size(); i != e; ++i) {
     const ELFRelocationEntry &Entry = Relocs[e - i - 1];
     unsigned Index = Entry.Symbol ? Entry.Symbol->getIndex() : 0;
 
     if (is64Bit()) {
-      write(Entry.Offset);
+      write(OS, Entry.Offset);
       if (TargetObjectWriter->isN64()) {
-        write(uint32_t(Index));
+        write(OS, uint32_t(Index));
 
-        write(TargetObjectWriter->getRSsym(Entry.Type));
-        write(TargetObjectWriter->getRType3(Entry.Type));
-        write(TargetObjectWriter->getRType2(Entry.Type));
-        write(TargetObjectWriter->getRType(Entry.Type));
+        write(OS, TargetObjectWriter->getRSsym(Entry.Type));
+        write(OS, TargetObjectWriter->getRType3(Entry.Type));
+        write(OS, TargetObjectWriter->getRType2(Entry.Type));
+        write(OS, TargetObjectWriter->getRType(Entry.Type));
       } else {
         struct ELF::Elf64_Rela ERE64;
         ERE64.setSymbolAndType(Index, Entry.Type);
-        write(ERE64.r_info);
+        write(OS, ERE64.r_info);
       }
       if (hasRelocationAddend())
-        write(Entry.Addend);
+        write(OS, Entry.Addend);
     } else {
-      write(uint32_t(Entry.Offset));
+      write(OS, uint32_t(Entry.Offset));
 
       struct ELF::Elf32_Rela ERE32;
       ERE32.setSymbolAndType(Index, Entry.Type);
-      write(ERE32.r_info);
+      write(OS, ERE32.r_info);
 
       if (hasRelocationAddend())
-        write(uint32_t(Entry.Addend));
+        write(OS, uint32_t(Entry.Addend));
     }
   }
 }
 
+// Below this number of relocation sections, the cost of starting threads
+// outweighs that of encoding the relocations serially.
+static const unsigned ParallelRelocationSectionThreshold = 256;
+
+void ELFObjectWriter::encodeRelocationSections(
+    const MCAssembler &Asm, ArrayRef<MCSectionELF *> RelSections,
+    MutableArrayRef<SmallVector<char, 0>> Out) {
+  assert(RelSections.size() == Out.size());
+
+  // Look the relocations up, and size the buffers, before going parallel:
+  // this is the only part that touches shared state.
+  std::vector<std::vector<ELFRelocationEntry> *> Relocs;
+  Relocs.reserve(RelSections.size());
+  for (unsigned I = 0, E = RelSections.size(); I != E; ++I) {
+    std::vector<ELFRelocationEntry> &SecRelocs =
+        Relocations[RelSections[I]->getAssociatedSection()];
+    Out[I].reserve(SecRelocs.size() * RelSections[I]->getEntrySize());
+    Relocs.push_back(&SecRelocs);
+  }
+
+  unsigned ThreadCount = llvm_is_multithreaded() ? Asm.getThreadCount() : 1;
+  if (ThreadCount <= 1 ||
+      RelSections.size() < ParallelRelocationSectionThreshold) {
+    for (unsigned I = 0, E = RelSections.size(); I != E; ++I)
+      encodeRelocations(Asm, *Relocs[I], Out[I]);
+    return;
+  }
+
+  // Each thread takes a contiguous range of sections, so that the work items
+  // stay coarse even with hundreds of thousands of sections.
+  unsigned ChunkSize = (RelSections.size() + ThreadCount - 1) / ThreadCount;
+  ThreadPool Pool(ThreadCount);
+  for (unsigned Begin = 0, E = RelSections.size(); Begin < E;
+       Begin += ChunkSize) {
+    unsigned End = std::min(Begin + ChunkSize, E);
+    Pool.async([this, &Asm, &Relocs, Out, Begin, End] {
+      for (unsigned I = Begin; I != End; ++I)
+        encodeRelocations(Asm, *Relocs[I], Out[I]);
+    });
+  }
+  Pool.wait();
+}
+
 const MCSectionELF *ELFObjectWriter::createStringTable(MCContext &Ctx) {
   const MCSectionELF *StrtabSection = SectionTable[StringTableIndex - 1];
   getStream() << StrTabBuilder.data();
@@ -1252,13 +1313,21 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
   // Compute symbol table information.
   computeSymbolTable(Asm, Layout, SectionIndexMap, RevGroupMap, SectionOffsets);
 
-  for (MCSectionELF *RelSection : Relocations) {
+  // The relocations only depend on the symbol indices computed above, so the
+  // relocation sections can all be encoded independently before being
+  // written out.
+  std::vector<SmallVector<char, 0>> EncodedRelocations(Relocations.size());
+  encodeRelocationSections(Asm, Relocations, EncodedRelocations);
+
+  for (unsigned I = 0, E = Relocations.size(); I != E; ++I) {
+    MCSectionELF *RelSection = Relocations[I];
     align(RelSection->getAlignment());
 
     // Remember the offset into the file for this section.
     uint64_t SecStart = getStream().tell();
 
-    writeRelocations(Asm, *RelSection->getAssociatedSection());
+    getStream() << StringRef(EncodedRelocations[I].data(),
+                             EncodedRelocations[I].size());
 
     uint64_t SecEnd = getStream().tell();
     SectionOffsets[RelSection] = std::make_pair(SecStart, SecEnd);
@@ -54,6 +54,7 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxationChecks, "Number of fragments checked for relaxation");
 }
 }
 
@@ -337,7 +338,7 @@ MCAssembler::MCAssembler(MCContext &Context_, MCAsmBackend &Backend_,
                          MCCodeEmitter &Emitter_, MCObjectWriter &Writer_)
     : Context(Context_), Backend(Backend_), Emitter(Emitter_), Writer(Writer_),
       BundleAlignSize(0), RelaxAll(false), SubsectionsViaSymbols(false),
-      ELFHeaderEFlags(0) {
+      ThreadCount(1), ELFHeaderEFlags(0) {
   VersionMinInfo.Major = 0; // Major version == 0 for "none specified"
 }
 
@@ -354,6 +355,7 @@ void MCAssembler::reset() {
   ThumbFuncs.clear();
   BundleAlignSize = 0;
   RelaxAll = false;
+  ThreadCount = 1;
   SubsectionsViaSymbols = false;
   ELFHeaderEFlags = 0;
   LOHContainer.reset();
@@ -910,8 +912,16 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
       Frag.setLayoutOrder(FragmentIndex++);
   }
 
+  // Collect the fragments whose size depends on the layout. All the others
+  // keep the size they were emitted with, so relaxation never looks at them.
+  std::vector<RelaxationWorklist> Worklists(size());
+  for (MCSection &Sec : *this)
+    for (MCFragment &Frag : Sec)
+      if (mayNeedRelaxation(Frag))
+        Worklists[Sec.getOrdinal()].push_back(&Frag);
+
   // Layout until everything fits.
-  while (layoutOnce(Layout))
+  while (layoutOnce(Layout, Worklists))
     continue;
 
   DEBUG_WITH_TYPE("mc-dump", {
@@ -1080,55 +1090,74 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
-  // Holds the first fragment which needed relaxing during this layout. It will
-  // remain NULL if none were relaxed.
-  // When a fragment is relaxed, all the fragments following it should get
-  // invalidated because their offset is going to change.
-  MCFragment *FirstRelaxedFragment = nullptr;
-
-  // Attempt to relax all the fragments in the section.
-  for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
-    bool RelaxedFrag = false;
-    switch(I->getKind()) {
-    default:
-      break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
-    case MCFragment::FT_Dwarf:
-      RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
-      break;
-    case MCFragment::FT_DwarfFrame:
-      RelaxedFrag =
-        relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
-      break;
-    case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
-      break;
-    }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = &*I;
-  }
-  if (FirstRelaxedFragment) {
-    Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
+bool MCAssembler::mayNeedRelaxation(const MCFragment &F) const {
+  switch (F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    assert(!getRelaxAll() &&
+           "Did not expect a MCRelaxableFragment in RelaxAll mode");
+    // Once an instruction has been relaxed to its largest form, it never
+    // changes size again.
+    return getBackend().mayNeedRelaxation(
+        cast<MCRelaxableFragment>(F).getInst());
+  case MCFragment::FT_Dwarf:
+  case MCFragment::FT_DwarfFrame:
+  case MCFragment::FT_LEB:
     return true;
   }
-  return false;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::relaxFragment(MCAsmLayout &Layout, MCFragment &F) {
+  ++stats::RelaxationChecks;
+  switch (F.getKind()) {
+  default:
+    llvm_unreachable("Fragment does not need relaxation!");
+  case MCFragment::FT_Relaxable:
+    return relaxInstruction(Layout, cast<MCRelaxableFragment>(F));
+  case MCFragment::FT_Dwarf:
+    return relaxDwarfLineAddr(Layout, cast<MCDwarfLineAddrFragment>(F));
+  case MCFragment::FT_DwarfFrame:
+    return relaxDwarfCallFrameFragment(Layout,
+                                       cast<MCDwarfCallFrameFragment>(F));
+  case MCFragment::FT_LEB:
+    return relaxLEB(Layout, cast<MCLEBFragment>(F));
+  }
+}
+
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                                    RelaxationWorklist &Worklist) {
+  bool WasRelaxed = false;
+
+  // Attempt to relax the fragments which may still change size, keeping those
+  // that may do so again on the worklist.
+  auto Out = Worklist.begin();
+  for (MCFragment *F : Worklist) {
+    assert(F->getParent() == &Sec && "Fragment on the wrong worklist!");
+    if (relaxFragment(Layout, *F)) {
+      // The fragments following F have moved. Drop their offsets right away,
+      // so that the remaining fragments of this iteration are checked against
+      // the new layout: offsets are recomputed lazily, and only as far as the
+      // next query needs them, so this does not re-walk the whole section.
+      Layout.invalidateFragmentsFrom(F);
+      WasRelaxed = true;
+    }
+    if (mayNeedRelaxation(*F))
+      *Out++ = F;
+  }
+  Worklist.erase(Out, Worklist.end());
+
+  return WasRelaxed;
+}
+
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             MutableArrayRef<RelaxationWorklist> Worklists) {
   ++stats::RelaxationSteps;
 
   bool WasRelaxed = false;
-  for (iterator it = begin(), ie = end(); it != ie; ++it) {
-    MCSection &Sec = *it;
-    while (layoutSectionOnce(Layout, Sec))
+  for (MCSection &Sec : *this) {
+    RelaxationWorklist &Worklist = Worklists[Sec.getOrdinal()];
+    while (layoutSectionOnce(Layout, Sec, Worklist))
       WasRelaxed = true;
   }
 
@@ -11,6 +11,8 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/COFF.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 
 #include <vector>
 
@@ -18,11 +20,11 @@ using namespace llvm;
 
 StringTableBuilder::StringTableBuilder(Kind K) : K(K) {}
 
-typedef std::pair<StringRef, size_t> StringPair;
+typedef std::pair<CachedHashStringRef, size_t> StringPair;
 
 // Returns the character at Pos from end of a string.
 static int charTailAt(StringPair *P, size_t Pos) {
-  StringRef S = P->first;
+  StringRef S = P->first.val();
   if (Pos >= S.size())
     return -1;
   return (unsigned char)S[S.size() - Pos - 1];
@@ -61,13 +63,57 @@ tailcall:
   }
 }
 
-void StringTableBuilder::finalize() {
-  std::vector<std::pair<StringRef, size_t> *> Strings;
+// Below this number of strings, sorting them on a single thread is faster
+// than starting a pool.
+static const size_t ParallelSortThreshold = 1 << 16;
+
+// Sorts like multikey_qsort(Begin, End, 0), splitting the strings into buckets
+// by their last character first, and then sorting the buckets on ThreadCount
+// threads.
+static void parallel_multikey_qsort(StringPair **Begin, StringPair **End,
+                                    unsigned ThreadCount) {
+  // Bucket 0 holds the empty string, bucket C + 1 the strings ending with C.
+  const unsigned NumBuckets = 257;
+  std::vector<size_t> Offsets(NumBuckets, 0);
+  for (StringPair **I = Begin; I != End; ++I)
+    ++Offsets[charTailAt(*I, 0) + 1];
+
+  // multikey_qsort puts the strings ending with the greatest character first,
+  // and the empty string last. Turn the bucket sizes into end offsets, and
+  // then into start offsets while distributing the strings.
+  size_t Offset = 0;
+  for (unsigned Bucket = NumBuckets; Bucket-- != 0;) {
+    Offset += Offsets[Bucket];
+    Offsets[Bucket] = Offset;
+  }
+  std::vector<StringPair *> Sorted(End - Begin);
+  for (StringPair **I = Begin; I != End; ++I)
+    Sorted[--Offsets[charTailAt(*I, 0) + 1]] = *I;
+  std::copy(Sorted.begin(), Sorted.end(), Begin);
+
+  // A bucket ends where the bucket for the next smaller character starts.
+  ThreadPool Pool(ThreadCount);
+  for (unsigned Bucket = 1; Bucket != NumBuckets; ++Bucket) {
+    StringPair **First = Begin + Offsets[Bucket];
+    StringPair **Last = Begin + Offsets[Bucket - 1];
+    if (Last - First > 1)
+      Pool.async([First, Last] { multikey_qsort(First, Last, 1); });
+  }
+  Pool.wait();
+}
+
+void StringTableBuilder::finalize(unsigned ThreadCount) {
+  std::vector<StringPair *> Strings;
   Strings.reserve(StringIndexMap.size());
-  for (std::pair<StringRef, size_t> &P : StringIndexMap)
+  for (StringPair &P : StringIndexMap)
     Strings.push_back(&P);
 
-  if (!Strings.empty())
+  if (!llvm_is_multithreaded())
+    ThreadCount = 1;
+  if (ThreadCount > 1 && Strings.size() >= ParallelSortThreshold)
+    parallel_multikey_qsort(&Strings[0], &Strings[0] + Strings.size(),
+                            ThreadCount);
+  else if (!Strings.empty())
     multikey_qsort(&Strings[0], &Strings[0] + Strings.size(), 0);
 
   switch (K) {
@@ -85,8 +131,8 @@ void StringTableBuilder::finalize() {
   }
 
   StringRef Previous;
-  for (std::pair<StringRef, size_t> *P : Strings) {
-    StringRef S = P->first;
+  for (StringPair *P : Strings) {
+    StringRef S = P->first.val();
     if (K == WinCOFF)
       assert(S.size() > COFF::NameSize && "Short string in COFF string table!");
 
@@ -128,14 +174,14 @@ void StringTableBuilder::clear() {
   StringIndexMap.clear();
 }
 
-size_t StringTableBuilder::getOffset(StringRef S) const {
+size_t StringTableBuilder::getOffset(CachedHashStringRef S) const {
   assert(isFinalized());
   auto I = StringIndexMap.find(S);
   assert(I != StringIndexMap.end() && "String is not in table!");
   return I->second;
 }
 
-size_t StringTableBuilder::add(StringRef S) {
+size_t StringTableBuilder::add(CachedHashStringRef S) {
   assert(!isFinalized());
   auto P = StringIndexMap.insert(std::make_pair(S, Size));
   if (P.second)
@@ -13,6 +13,7 @@
 
 #include "llvm/Object/ArchiveWriter.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Object/Archive.h"
@@ -23,8 +24,11 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
 #include <unistd.h>
@@ -218,25 +222,139 @@ static sys::TimeValue now(bool Deterministic) {
   return TV;
 }
 
+namespace {
+// The entries a member contributes to the archive symbol table.
+struct MemberSymbols {
+  // Whether the member is a symbolic file at all. The symbol table is only
+  // written if at least one member is, even if none defines any symbol.
+  bool IsSymbolic = false;
+  // The names of the symbols, each one terminated by a NUL character.
+  std::string Names;
+  std::error_code EC;
+};
+}
+
+static void computeMemberSymbols(MemoryBufferRef MemberBuffer,
+                                 MemberSymbols &Symbols) {
+  // Every member gets its own context, so that bitcode members can be read
+  // on different threads.
+  LLVMContext Context;
+  ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
+      object::SymbolicFile::createSymbolicFile(
+          MemberBuffer, sys::fs::file_magic::unknown, &Context);
+  if (!ObjOrErr)
+    return; // FIXME: check only for "not an object file" errors.
+  object::SymbolicFile &Obj = *ObjOrErr.get();
+  Symbols.IsSymbolic = true;
+
+  raw_string_ostream NameOS(Symbols.Names);
+  for (const object::BasicSymbolRef &S : Obj.symbols()) {
+    uint32_t Symflags = S.getFlags();
+    if (Symflags & object::SymbolRef::SF_FormatSpecific)
+      continue;
+    if (!(Symflags & object::SymbolRef::SF_Global))
+      continue;
+    if (Symflags & object::SymbolRef::SF_Undefined)
+      continue;
+
+    if (auto EC = S.printName(NameOS)) {
+      Symbols.EC = EC;
+      return;
+    }
+    NameOS << '\0';
+  }
+}
+
+// Collect the symbol table entries of the old members from the symbol tables
+// of the archives they come from, keyed by the parent archive and the offset
+// of the member in it.
+typedef DenseMap<std::pair<const object::Archive *, uint64_t>, std::string>
+    OldSymbolMapType;
+
+static std::error_code
+collectOldSymbols(ArrayRef<NewArchiveIterator> Members,
+                  OldSymbolMapType &OldSymbols) {
+  std::vector<const object::Archive *> Parents;
+  for (const NewArchiveIterator &Member : Members) {
+    if (Member.isNewMember())
+      continue;
+    const object::Archive *Parent = Member.getOld().getParent();
+    if (!Parent->hasSymbolTable() ||
+        std::find(Parents.begin(), Parents.end(), Parent) != Parents.end())
+      continue;
+    Parents.push_back(Parent);
+
+    for (const object::Archive::Symbol &S : Parent->symbols()) {
+      ErrorOr<object::Archive::Child> ChildOrErr = S.getMember();
+      if (auto EC = ChildOrErr.getError())
+        return EC;
+      std::string &Names =
+          OldSymbols[std::make_pair(Parent, ChildOrErr->getChildOffset())];
+      Names += S.getName();
+      Names += '\0';
+    }
+  }
+  return std::error_code();
+}
+
+// Compute the symbol table entries of every member. Members are read on up to
+// ThreadCount threads, but the result does not depend on the order in which
+// they are.
+static void computeSymbols(ArrayRef<NewArchiveIterator> Members,
+                           ArrayRef<MemoryBufferRef> Buffers,
+                           const OldSymbolMapType &OldSymbols,
+                           std::vector<MemberSymbols> &Symbols,
+                           unsigned ThreadCount) {
+  Symbols.resize(Members.size());
+  std::vector<unsigned> ToRead;
+  for (unsigned MemberNum = 0, N = Members.size(); MemberNum < N;
+       ++MemberNum) {
+    const NewArchiveIterator &Member = Members[MemberNum];
+    if (!Member.isNewMember()) {
+      const object::Archive::Child &OldMember = Member.getOld();
+      auto I = OldSymbols.find(std::make_pair(OldMember.getParent(),
+                                              OldMember.getChildOffset()));
+      if (I != OldSymbols.end()) {
+        Symbols[MemberNum].IsSymbolic = true;
+        Symbols[MemberNum].Names = I->second;
+        continue;
+      }
+    }
+    ToRead.push_back(MemberNum);
+  }
+
+  if (!llvm_is_multithreaded())
+    ThreadCount = 1;
+  ThreadCount = std::min<unsigned>(ThreadCount, ToRead.size());
+  if (ThreadCount <= 1) {
+    for (unsigned MemberNum : ToRead)
+      computeMemberSymbols(Buffers[MemberNum], Symbols[MemberNum]);
+    return;
+  }
+
+  ThreadPool Pool(ThreadCount);
+  for (unsigned MemberNum : ToRead)
+    Pool.async([&Buffers, &Symbols, MemberNum] {
+      computeMemberSymbols(Buffers[MemberNum], Symbols[MemberNum]);
+    });
+  Pool.wait();
+}
+
 // Returns the offset of the first reference to a member offset.
 static ErrorOr<unsigned>
 writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
-                 ArrayRef<NewArchiveIterator> Members,
-                 ArrayRef<MemoryBufferRef> Buffers,
+                 ArrayRef<MemberSymbols> Symbols,
                  std::vector<unsigned> &MemberOffsetRefs, bool Deterministic) {
   unsigned HeaderStartOffset = 0;
   unsigned BodyStartOffset = 0;
   SmallString<128> NameBuf;
   raw_svector_ostream NameOS(NameBuf);
-  LLVMContext Context;
-  for (unsigned MemberNum = 0, N = Members.size(); MemberNum < N; ++MemberNum) {
-    MemoryBufferRef MemberBuffer = Buffers[MemberNum];
-    ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
-        object::SymbolicFile::createSymbolicFile(
-            MemberBuffer, sys::fs::file_magic::unknown, &Context);
-    if (!ObjOrErr)
-      continue;  // FIXME: check only for "not an object file" errors.
-    object::SymbolicFile &Obj = *ObjOrErr.get();
+  for (unsigned MemberNum = 0, N = Symbols.size(); MemberNum < N; ++MemberNum) {
+    const MemberSymbols &MemberSyms = Symbols[MemberNum];
+    if (MemberSyms.EC)
+      return MemberSyms.EC;
+    if (!MemberSyms.IsSymbolic)
+      continue;
 
     if (!HeaderStartOffset) {
       HeaderStartOffset = Out.tell();
@@ -248,19 +366,13 @@ writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
       print32(Out, Kind, 0); // number of entries or bytes
     }
 
-    for (const object::BasicSymbolRef &S : Obj.symbols()) {
-      uint32_t Symflags = S.getFlags();
-      if (Symflags & object::SymbolRef::SF_FormatSpecific)
-        continue;
-      if (!(Symflags & object::SymbolRef::SF_Global))
-        continue;
-      if (Symflags & object::SymbolRef::SF_Undefined)
-        continue;
+    StringRef Names = MemberSyms.Names;
+    while (!Names.empty()) {
+      StringRef Name;
+      std::tie(Name, Names) = Names.split('\0');
 
       unsigned NameOffset = NameOS.tell();
-      if (auto EC = S.printName(NameOS))
-        return EC;
-      NameOS << '\0';
+      NameOS << Name << '\0';
       MemberOffsetRefs.push_back(MemberNum);
       if (Kind == object::Archive::K_BSD)
         print32(Out, Kind, NameOffset);
@@ -304,7 +416,8 @@ std::pair<StringRef, std::error_code>
 llvm::writeArchive(StringRef ArcName,
                    std::vector<NewArchiveIterator> &NewMembers,
                    bool WriteSymtab, object::Archive::Kind Kind,
-                   bool Deterministic, bool Thin) {
+                   bool Deterministic, bool Thin, bool ReuseOldSymtab,
+                   unsigned ThreadCount) {
   SmallString<128> TmpArchive;
   int TmpArchiveFD;
   if (auto EC = sys::fs::createUniqueFile(ArcName + ".temp-archive-%%%%%%%.a",
@@ -360,8 +473,15 @@ llvm::writeArchive(StringRef ArcName,
 
   unsigned MemberReferenceOffset = 0;
   if (WriteSymtab) {
+    OldSymbolMapType OldSymbols;
+    if (ReuseOldSymtab)
+      if (auto EC = collectOldSymbols(NewMembers, OldSymbols))
+        return std::make_pair(ArcName, EC);
+    std::vector<MemberSymbols> Symbols;
+    computeSymbols(NewMembers, Members, OldSymbols, Symbols, ThreadCount);
+
     ErrorOr<unsigned> MemberReferenceOffsetOrErr = writeSymbolTable(
-        Out, Kind, NewMembers, Members, MemberOffsetRefs, Deterministic);
+        Out, Kind, Symbols, MemberOffsetRefs, Deterministic);
     if (auto EC = MemberReferenceOffsetOrErr.getError())
       return std::make_pair(ArcName, EC);
     MemberReferenceOffset = MemberReferenceOffsetOrErr.get();
@@ -45,6 +45,9 @@ Enabled(
     "stats",
     cl::desc("Enable statistics output from program (available with Asserts)"));
 
+static cl::opt<bool> StatsAsJSON("stats-json",
+                                 cl::desc("Display statistics as json data"));
+
 
 namespace {
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
@@ -54,6 +57,7 @@ class StatisticInfo {
   std::vector<const Statistic*> Stats;
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
 public:
   ~StatisticInfo();
 
@@ -72,16 +76,12 @@ void Statistic::RegisterStatistic() {
   // If stats are enabled, inform StatInfo that this statistic should be
   // printed.
   sys::SmartScopedLock<true> Writer(*StatLock);
-  if (!Initialized) {
-    if (Enabled)
+  if (!Initialized.load(std::memory_order_relaxed)) {
+    if (Enabled || StatsAsJSON)
       StatInfo->addStatistic(this);
 
-    TsanHappensBefore(this);
-    sys::MemoryFence();
     // Remember we have been registered.
-    TsanIgnoreWritesBegin();
-    Initialized = true;
-    TsanIgnoreWritesEnd();
+    Initialized.store(true, std::memory_order_release);
   }
 }
 
@@ -94,8 +94,24 @@ void llvm::EnableStatistics() {
   Enabled.setValue(true);
 }
 
+void llvm::DisableStatistics() {
+  Enabled.setValue(false);
+}
+
 bool llvm::AreStatisticsEnabled() {
-  return Enabled;
+  return Enabled || StatsAsJSON;
+}
+
+// Sort the statistics by name, then by description.
+static void sortStatistics(std::vector<const Statistic*> &Stats) {
+  std::stable_sort(Stats.begin(), Stats.end(),
+                   [](const Statistic *LHS, const Statistic *RHS) {
+    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
+      return Cmp < 0;
+
+    // Secondary key is the description.
+    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
+  });
 }
 
 void llvm::PrintStatistics(raw_ostream &OS) {
@@ -111,14 +127,7 @@ void llvm::PrintStatistics(raw_ostream &OS) {
   }
 
   // Sort the fields by name.
-  std::stable_sort(Stats.Stats.begin(), Stats.Stats.end(),
-                   [](const Statistic *LHS, const Statistic *RHS) {
-    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
-      return Cmp < 0;
-
-    // Secondary key is the description.
-    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
-  });
+  sortStatistics(Stats.Stats);
 
   // Print out the statistics header...
   OS << "===" << std::string(73, '-') << "===\n"
@@ -137,22 +146,60 @@ void llvm::PrintStatistics(raw_ostream &OS) {
 
 }
 
+static void printJSONString(raw_ostream &OS, const char *Str) {
+  OS << '"';
+  for (; *Str; ++Str) {
+    unsigned char C = *Str;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void llvm::PrintStatisticsJSON(raw_ostream &OS) {
+  StatisticInfo &Stats = *StatInfo;
+
+  sortStatistics(Stats.Stats);
+
+  OS << "[\n";
+  for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i) {
+    const Statistic *S = Stats.Stats[i];
+    OS << "  {\"type\": ";
+    printJSONString(OS, S->getName());
+    OS << ", \"desc\": ";
+    printJSONString(OS, S->getDesc());
+    OS << ", \"value\": " << S->getValue() << '}';
+    if (i + 1 != e)
+      OS << ',';
+    OS << '\n';
+  }
+  OS << "]\n";
+  OS.flush();
+}
+
 void llvm::PrintStatistics() {
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
   StatisticInfo &Stats = *StatInfo;
 
   // Statistics not enabled?
-  if (Stats.Stats.empty()) return;
+  if (Stats.Stats.empty() || !AreStatisticsEnabled()) return;
 
   // Get the stream to write to.
   raw_ostream &OutStream = *CreateInfoOutputFile();
-  PrintStatistics(OutStream);
+  if (StatsAsJSON)
+    PrintStatisticsJSON(OutStream);
+  else
+    PrintStatistics(OutStream);
   delete &OutStream;   // Close the file.
 #else
   // Check if the -stats option is set instead of checking
   // !Stats.Stats.empty().  In release builds, Statistics operators
   // do nothing, so stats are never Registered.
-  if (Enabled) {
+  if (Enabled || StatsAsJSON) {
     // Get the stream to write to.
     raw_ostream &OutStream = *CreateInfoOutputFile();
     OutStream << "Statistics are disabled.  "
@@ -144,14 +144,25 @@ TimeRecord TimeRecord::getCurrentTime(bool Start) {
 
 static ManagedStatic<std::vector<Timer*> > ActiveTimers;
 
+/// ActiveTimersLock - Guards ActiveTimers and the Started flag and TimeRecord of
+/// every Timer, so that a Timer (e.g. a per-pass timer) may be started and
+/// stopped from several threads at once. The time is sampled before the lock is
+/// taken so that contention is not attributed to the timer. TimerGroup takes
+/// this lock after TimerLock whenever it reads or resets a Timer's time.
+static ManagedStatic<sys::SmartMutex<true> > ActiveTimersLock;
+
 void Timer::startTimer() {
+  TimeRecord Now = TimeRecord::getCurrentTime(true);
+  sys::SmartScopedLock<true> L(*ActiveTimersLock);
   Started = true;
   ActiveTimers->push_back(this);
-  Time -= TimeRecord::getCurrentTime(true);
+  Time -= Now;
 }
 
 void Timer::stopTimer() {
-  Time += TimeRecord::getCurrentTime(false);
+  TimeRecord Now = TimeRecord::getCurrentTime(false);
+  sys::SmartScopedLock<true> L(*ActiveTimersLock);
+  Time += Now;
 
   if (ActiveTimers->back() == this) {
     ActiveTimers->pop_back();
@@ -163,6 +174,22 @@ void Timer::stopTimer() {
   }
 }
 
+bool Timer::isRunning() const {
+  sys::SmartScopedLock<true> L(*ActiveTimersLock);
+  return std::find(ActiveTimers->begin(), ActiveTimers->end(), this) !=
+         ActiveTimers->end();
+}
+
+bool Timer::hasTriggered() const {
+  sys::SmartScopedLock<true> L(*ActiveTimersLock);
+  return Started;
+}
+
+TimeRecord Timer::getTotalTime() const {
+  sys::SmartScopedLock<true> L(*ActiveTimersLock);
+  return Time;
+}
+
 static void printVal(double Val, double Total, raw_ostream &OS) {
   if (Total < 1e-7)   // Avoid dividing by zero.
     OS << "        -----     ";
@@ -278,8 +305,11 @@ void TimerGroup::removeTimer(Timer &T) {
   sys::SmartScopedLock<true> L(*TimerLock);
   
   // If the timer was started, move its data to TimersToPrint.
-  if (T.Started)
-    TimersToPrint.push_back(std::make_pair(T.Time, T.Name));
+  {
+    sys::SmartScopedLock<true> TL(*ActiveTimersLock);
+    if (T.Started)
+      TimersToPrint.push_back(std::make_pair(T.Time, T.Name));
+  }
 
   T.TG = nullptr;
   
@@ -364,13 +394,16 @@ void TimerGroup::print(raw_ostream &OS) {
 
   // See if any of our timers were started, if so add them to TimersToPrint and
   // reset them.
-  for (Timer *T = FirstTimer; T; T = T->Next) {
-    if (!T->Started) continue;
-    TimersToPrint.push_back(std::make_pair(T->Time, T->Name));
-    
-    // Clear out the time.
-    T->Started = 0;
-    T->Time = TimeRecord();
+  {
+    sys::SmartScopedLock<true> TL(*ActiveTimersLock);
+    for (Timer *T = FirstTimer; T; T = T->Next) {
+      if (!T->Started) continue;
+      TimersToPrint.push_back(std::make_pair(T->Time, T->Name));
+
+      // Clear out the time.
+      T->Started = 0;
+      T->Time = TimeRecord();
+    }
   }
 
   // If any timers were started, print the group.
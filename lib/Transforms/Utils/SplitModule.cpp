@@ -14,7 +14,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalObject.h"
@@ -23,9 +26,139 @@
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <queue>
 
 using namespace llvm;
 
+namespace {
+typedef EquivalenceClasses<const GlobalValue *> ClusterMapType;
+typedef DenseMap<const Comdat *, const GlobalValue *> ComdatMembersType;
+typedef DenseMap<const GlobalValue *, unsigned> ClusterIDMapType;
+}
+
+// Put every global value that uses V, directly or through constants, into the
+// same cluster as GV.
+static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
+                                   const GlobalValue *GV, const Value *V) {
+  for (const User *U : V->users()) {
+    if (auto *I = dyn_cast<Instruction>(U)) {
+      GVtoClusterMap.unionSets(GV, I->getParent()->getParent());
+    } else if (auto *UGV = dyn_cast<GlobalValue>(U)) {
+      GVtoClusterMap.unionSets(GV, UGV);
+    } else if (isa<Constant>(U)) {
+      // Constants such as constant expressions and block addresses have no
+      // partition of their own; look through them.
+      addAllGlobalValueUsers(GVtoClusterMap, GV, U);
+    }
+  }
+}
+
+// Returns the number of instructions of GV, which serves as an estimate of the
+// code generation cost of its definition.
+static uint64_t getCodeGenCost(const GlobalValue *GV) {
+  if (GV->isDeclaration())
+    return 0;
+  auto *F = dyn_cast<Function>(GV);
+  if (!F)
+    return 1;
+  uint64_t Cost = 0;
+  for (const BasicBlock &BB : *F)
+    Cost += BB.size();
+  return Cost;
+}
+
+// Group the global values of M into clusters that must end up in the same
+// partition, and assign each cluster to one of N partitions so that the
+// number of instructions in each partition is balanced.
+//
+// A cluster holds the members of a comdat, an alias and its base object, and
+// every local value together with all of its users, so that locals never need
+// to be externalized.
+static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
+                           unsigned N) {
+  ClusterMapType GVtoClusterMap;
+  ComdatMembersType ComdatMembers;
+
+  auto recordGVSet = [&GVtoClusterMap, &ComdatMembers](GlobalValue &GV) {
+    if (GV.isDeclaration())
+      return;
+
+    if (!GV.hasName())
+      GV.setName("__llvmsplit_unnamed");
+
+    GVtoClusterMap.insert(&GV);
+
+    if (const Comdat *C = GV.getComdat()) {
+      auto &Member = ComdatMembers[C];
+      if (Member)
+        GVtoClusterMap.unionSets(Member, &GV);
+      else
+        Member = &GV;
+    }
+
+    if (auto *GA = dyn_cast<GlobalAlias>(&GV))
+      if (const GlobalObject *Base = GA->getBaseObject())
+        GVtoClusterMap.unionSets(&GV, Base);
+
+    // A block address can only be materialized in the module that defines the
+    // function it refers to.
+    if (const Function *F = dyn_cast<Function>(&GV)) {
+      for (const User *U : F->users())
+        if (isa<BlockAddress>(U))
+          addAllGlobalValueUsers(GVtoClusterMap, F, U);
+    }
+
+    if (GV.hasLocalLinkage())
+      addAllGlobalValueUsers(GVtoClusterMap, &GV, &GV);
+  };
+
+  std::for_each(M->begin(), M->end(), recordGVSet);
+  std::for_each(M->global_begin(), M->global_end(), recordGVSet);
+  std::for_each(M->alias_begin(), M->alias_end(), recordGVSet);
+
+  // Accumulate the cost of every cluster, walking the module so that the
+  // result does not depend on the address of the global values.
+  MapVector<const GlobalValue *, uint64_t> ClusterCosts;
+  auto accumulateCost = [&](const GlobalValue &GV) {
+    if (GVtoClusterMap.findValue(&GV) == GVtoClusterMap.end())
+      return;
+    ClusterCosts[GVtoClusterMap.getLeaderValue(&GV)] += getCodeGenCost(&GV);
+  };
+  std::for_each(M->begin(), M->end(), accumulateCost);
+  std::for_each(M->global_begin(), M->global_end(), accumulateCost);
+  std::for_each(M->alias_begin(), M->alias_end(), accumulateCost);
+
+  // Assign the most expensive clusters first, each one to the partition that
+  // currently has the lowest cost.
+  std::vector<std::pair<const GlobalValue *, uint64_t>> Sorted(
+      ClusterCosts.begin(), ClusterCosts.end());
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const std::pair<const GlobalValue *, uint64_t> &A,
+                      const std::pair<const GlobalValue *, uint64_t> &B) {
+                     return A.second > B.second;
+                   });
+
+  typedef std::pair<uint64_t, unsigned> PartitionLoad;
+  std::priority_queue<PartitionLoad, std::vector<PartitionLoad>,
+                      std::greater<PartitionLoad>>
+      Loads;
+  for (unsigned I = 0; I != N; ++I)
+    Loads.push(PartitionLoad(0, I));
+
+  for (const auto &Cluster : Sorted) {
+    PartitionLoad Load = Loads.top();
+    Loads.pop();
+    for (ClusterMapType::member_iterator
+             MI = GVtoClusterMap.findLeader(Cluster.first),
+             ME = GVtoClusterMap.member_end();
+         MI != ME; ++MI)
+      ClusterIDMap[*MI] = Load.second;
+    Load.first += Cluster.second;
+    Loads.push(Load);
+  }
+}
+
 static void externalize(GlobalValue *GV) {
   if (GV->hasLocalLinkage()) {
     GV->setLinkage(GlobalValue::ExternalLinkage);
@@ -62,21 +195,33 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
 
 void llvm::SplitModule(
     std::unique_ptr<Module> M, unsigned N,
-    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback) {
-  for (Function &F : *M)
-    externalize(&F);
-  for (GlobalVariable &GV : M->globals())
-    externalize(&GV);
-  for (GlobalAlias &GA : M->aliases())
-    externalize(&GA);
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback,
+    bool PreserveLocals) {
+  ClusterIDMapType ClusterIDMap;
+  if (PreserveLocals) {
+    findPartitions(M.get(), ClusterIDMap, N);
+  } else {
+    for (Function &F : *M)
+      externalize(&F);
+    for (GlobalVariable &GV : M->globals())
+      externalize(&GV);
+    for (GlobalAlias &GA : M->aliases())
+      externalize(&GA);
+  }
 
   // FIXME: We should be able to reuse M as the last partition instead of
   // cloning it.
   for (unsigned I = 0; I != N; ++I) {
     ValueToValueMapTy VMap;
     std::unique_ptr<Module> MPart(
-        CloneModule(M.get(), VMap, [=](const GlobalValue *GV) {
-          return isInPartition(GV, I, N);
+        CloneModule(M.get(), VMap, [&](const GlobalValue *GV) {
+          if (!PreserveLocals)
+            return isInPartition(GV, I, N);
+          // Declarations keep their linkage in every partition.
+          if (GV->isDeclaration())
+            return true;
+          auto It = ClusterIDMap.find(GV);
+          return It != ClusterIDMap.end() && It->second == I;
         }));
     if (I != 0)
       MPart->setModuleInlineAsm("");
@@ -0,0 +1,69 @@
+; Encoding the function blocks on several threads must produce the same bytes
+; as the serial writer, both with and without a function summary.
+; RUN: llvm-as < %s -o %t.serial.bc
+; RUN: llvm-as -bitcode-writer-threads=3 < %s -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-as -function-summary < %s -o %t.serial.sum.bc
+; RUN: llvm-as -function-summary -bitcode-writer-threads=3 < %s -o %t.parallel.sum.bc
+; RUN: cmp %t.serial.sum.bc %t.parallel.sum.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+
+; CHECK: @g = global i32 42
+@g = global i32 42
+@str = private constant [6 x i8] c"hello\00"
+
+declare void @ext(i8*)
+
+; CHECK-LABEL: define i32 @f1(
+define i32 @f1(i32 %a, i32 %b) !dbg !6 {
+entry:
+  %sum = add nsw i32 %a, %b, !dbg !10
+  %cmp = icmp sgt i32 %sum, 7, !dbg !10
+  br i1 %cmp, label %then, label %else
+
+then:
+  %v = load i32, i32* @g, !tbaa !0
+  br label %else
+
+else:
+  %r = phi i32 [ %sum, %entry ], [ %v, %then ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: define void @f2(
+define void @f2() {
+  call void @ext(i8* getelementptr ([6 x i8], [6 x i8]* @str, i32 0, i32 0))
+  call void @ext(i8* blockaddress(@f3, %target))
+  ret void
+}
+
+; CHECK-LABEL: define internal float @f3(
+define internal float @f3(float %x) {
+  br label %target
+
+target:
+  %y = fmul float %x, 2.500000e+00
+  %z = fadd float %y, 0x3FB99999A0000000
+  ret float %z
+}
+
+; CHECK-LABEL: define <4 x i32> @f4(
+define <4 x i32> @f4(<4 x i32> %v) {
+  %s = shufflevector <4 x i32> %v, <4 x i32> <i32 1, i32 2, i32 3, i32 4>, <4 x i32> <i32 0, i32 5, i32 2, i32 7>
+  ret <4 x i32> %s
+}
+
+!llvm.dbg.cu = !{!3}
+!llvm.module.flags = !{!9}
+
+!0 = !{!1, !1, i64 0}
+!1 = !{!"int", !2}
+!2 = !{!"tbaa root"}
+!3 = distinct !DICompileUnit(language: DW_LANG_C99, file: !4, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: 1, subprograms: !5)
+!4 = !DIFile(filename: "t.c", directory: "/tmp")
+!5 = !{!6}
+!6 = distinct !DISubprogram(name: "f1", scope: !4, file: !4, line: 1, type: !7, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: false)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null}
+!9 = !{i32 2, !"Debug Info Version", i32 3}
+!10 = !DILocation(line: 2, column: 3, scope: !6)
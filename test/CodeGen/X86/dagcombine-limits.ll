@@ -0,0 +1,27 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -combiner-print-counts \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -combiner-print-counts \
+; RUN:   -combiner-dag-limit=1 -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=DAG-LIMIT
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -combiner-node-limit=1 \
+; RUN:   | FileCheck %s --check-prefix=NODE-LIMIT
+
+; CHECK: DAG combines in 'f' before type legalization: {{[0-9]+}} attempted, {{[0-9]+}} fired
+; CHECK: {{^  [A-Za-z_]+: [0-9]+ attempted, [0-9]+ fired$}}
+; CHECK: DAG combines in 'f' after DAG legalization: {{[0-9]+}} attempted, {{[0-9]+}} fired
+
+; With a budget of one combine per run, only one node is looked at each time.
+; DAG-LIMIT: DAG combines in 'f' before type legalization: 1 attempted
+; DAG-LIMIT: DAG combines in 'f' after DAG legalization: 1 attempted
+
+; Limiting the combines per node still produces correct code.
+; NODE-LIMIT-LABEL: f:
+; NODE-LIMIT: leal
+; NODE-LIMIT: retq
+
+define i32 @f(i32 %a, i32 %b) {
+  %x = add i32 %a, 0
+  %y = shl i32 %b, 1
+  %z = add i32 %x, %y
+  ret i32 %z
+}
@@ -0,0 +1,70 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -mattr=+avx2 -stats \
+; RUN:   -o %t.cached 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -mattr=+avx2 -stats \
+; RUN:   -disable-isel-switch-cache -o %t.scanned 2>&1 \
+; RUN:   | FileCheck --check-prefix=NOCACHE %s
+; RUN: cmp %t.cached %t.scanned
+; REQUIRES: asserts
+
+; Dispatching nested opcode switches through the cache selects the same
+; instructions as scanning their cases. @repeated selects the same load, xor
+; and store four times, so the switches those reach are dispatched through the
+; cache more than once.
+
+; CHECK: {{^ *}}{{[2-9]|[1-9][0-9]+}} isel - Number of nested opcode switches dispatched through the cache
+; NOCACHE-NOT: Number of nested opcode switches dispatched through the cache
+
+define i32 @scalar(i32* %p, i32 %a, i32 %b) {
+  %l = load i32, i32* %p
+  %x = add i32 %l, %a
+  %y = shl i32 %x, 3
+  %z = xor i32 %y, %b
+  %w = and i32 %z, %l
+  %s = sub i32 %w, %a
+  %m = mul i32 %s, %l
+  store i32 %m, i32* %p
+  %c = icmp ult i32 %m, %b
+  %r = select i1 %c, i32 %m, i32 %x
+  ret i32 %r
+}
+
+define <8 x i32> @vector(<8 x i32>* %p, <8 x i32> %a, <8 x i32> %b) {
+  %l = load <8 x i32>, <8 x i32>* %p
+  %x = add <8 x i32> %l, %a
+  %y = shl <8 x i32> %x, <i32 1, i32 2, i32 3, i32 4, i32 5, i32 6, i32 7, i32 8>
+  %z = xor <8 x i32> %y, %b
+  %w = and <8 x i32> %z, %l
+  %m = mul <8 x i32> %w, %a
+  store <8 x i32> %m, <8 x i32>* %p
+  ret <8 x i32> %m
+}
+
+define double @fp(double* %p, double %a, float %f) {
+  %l = load double, double* %p
+  %e = fpext float %f to double
+  %x = fadd double %l, %a
+  %y = fmul double %x, %e
+  %z = fdiv double %y, %l
+  %i = fptosi double %z to i64
+  %j = sitofp i64 %i to double
+  ret double %j
+}
+
+define void @repeated(i32* %p, i32 %a) {
+  %l0 = load i32, i32* %p
+  %x0 = xor i32 %l0, %a
+  store i32 %x0, i32* %p
+  %p1 = getelementptr i32, i32* %p, i64 1
+  %l1 = load i32, i32* %p1
+  %x1 = xor i32 %l1, %a
+  store i32 %x1, i32* %p1
+  %p2 = getelementptr i32, i32* %p, i64 2
+  %l2 = load i32, i32* %p2
+  %x2 = xor i32 %l2, %a
+  store i32 %x2, i32* %p2
+  %p3 = getelementptr i32, i32* %p, i64 3
+  %l3 = load i32, i32* %p3
+  %x3 = xor i32 %l3, %a
+  store i32 %x3, i32* %p3
+  ret void
+}
@@ -0,0 +1,34 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched \
+; RUN:   -misched-postra -stats -o %t.skipped 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched \
+; RUN:   -misched-postra -misched-skip-chains=false -stats -o %t.scheduled 2>&1 \
+; RUN:   | FileCheck --check-prefix=NOSKIP %s
+; RUN: cmp %t.skipped %t.scheduled
+; REQUIRES: asserts
+
+; Regions that are a single dependence chain are left alone rather than
+; scheduled, which must not change their order. The body of @chain is one
+; region in which every instruction reads the result of the one above it,
+; starting from the copy of its only argument. @independent has two loads that
+; do not depend on each other, so its region is scheduled.
+
+; CHECK: {{^ *}}1 misched - Number of dependence chain regions not scheduled
+; NOSKIP-NOT: Number of dependence chain regions not scheduled
+
+define i64 @chain(i64 %a) {
+  %x = add i64 %a, 5
+  %y = mul i64 %x, %x
+  %z = xor i64 %y, 7
+  %w = shl i64 %z, 3
+  ret i64 %w
+}
+
+define i64 @independent(i64* %p, i64 %a, i64 %b) {
+  %l0 = load i64, i64* %p
+  %q = getelementptr i64, i64* %p, i64 1
+  %l1 = load i64, i64* %q
+  %x = add i64 %l0, %a
+  %y = add i64 %l1, %b
+  %z = mul i64 %x, %y
+  ret i64 %z
+}
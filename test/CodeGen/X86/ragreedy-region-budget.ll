@@ -0,0 +1,68 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs \
+; RUN:   | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs \
+; RUN:   -grow-region-complexity-budget=0 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -stats -o /dev/null 2>&1 \
+; RUN:   | FileCheck --check-prefix=DEFAULT %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown \
+; RUN:   -grow-region-complexity-budget=0 -stats -o /dev/null 2>&1 \
+; RUN:   | FileCheck --check-prefix=NOBUDGET %s
+; REQUIRES: asserts
+
+; Giving up on region splitting because of the complexity budget must still
+; produce a valid allocation. The default budget is never exceeded here.
+
+; DEFAULT-NOT: Number of region splits given up on for compile time
+; NOBUDGET: {{[1-9][0-9]*}} regalloc - Number of region splits given up on for compile time
+
+; CHECK-LABEL: pressure:
+; CHECK: callq g
+; CHECK: retq
+
+declare void @g(i64)
+
+define i64 @pressure(i64* %p, i64 %n) {
+entry:
+  %a0 = load i64, i64* %p
+  %p1 = getelementptr i64, i64* %p, i64 1
+  %a1 = load i64, i64* %p1
+  %p2 = getelementptr i64, i64* %p, i64 2
+  %a2 = load i64, i64* %p2
+  %p3 = getelementptr i64, i64* %p, i64 3
+  %a3 = load i64, i64* %p3
+  %p4 = getelementptr i64, i64* %p, i64 4
+  %a4 = load i64, i64* %p4
+  %p5 = getelementptr i64, i64* %p, i64 5
+  %a5 = load i64, i64* %p5
+  %p6 = getelementptr i64, i64* %p, i64 6
+  %a6 = load i64, i64* %p6
+  %p7 = getelementptr i64, i64* %p, i64 7
+  %a7 = load i64, i64* %p7
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+  %acc = phi i64 [ 0, %entry ], [ %acc.next, %latch ]
+  %s0 = add i64 %acc, %a0
+  %s1 = xor i64 %s0, %a1
+  %s2 = add i64 %s1, %a2
+  %s3 = xor i64 %s2, %a3
+  %c = icmp ult i64 %s3, %n
+  br i1 %c, label %call, label %latch
+
+call:
+  call void @g(i64 %s3)
+  br label %latch
+
+latch:
+  %s4 = add i64 %s3, %a4
+  %s5 = xor i64 %s4, %a5
+  %s6 = add i64 %s5, %a6
+  %acc.next = xor i64 %s6, %a7
+  %i.next = add i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i64 %acc.next
+}
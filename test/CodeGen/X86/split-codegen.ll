@@ -0,0 +1,35 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-codegen=2 -o %t.s %s
+; RUN: FileCheck --check-prefix=CHECK0 %s < %t.s.0
+; RUN: FileCheck --check-prefix=CHECK1 %s < %t.s.1
+
+; @big gets a partition of its own, while @small and the internal @helper it
+; calls share the other one, where @helper remains local.
+
+; CHECK0: .globl big
+; CHECK0: big:
+; CHECK0-NOT: small:
+; CHECK0-NOT: helper:
+define i32 @big(i32 %x) {
+  %a = mul i32 %x, %x
+  %b = add i32 %a, 7
+  %c = mul i32 %b, %x
+  %d = add i32 %c, 11
+  %e = mul i32 %d, %b
+  ret i32 %e
+}
+
+; CHECK1-NOT: big:
+; CHECK1-NOT: .globl helper
+; CHECK1: helper:
+; CHECK1: .globl small
+; CHECK1: small:
+; CHECK1: callq helper
+define internal i32 @helper(i32 %x) noinline {
+  %a = add i32 %x, 1
+  ret i32 %a
+}
+
+define i32 @small(i32 %x) {
+  %r = call i32 @helper(i32 %x)
+  ret i32 %r
+}
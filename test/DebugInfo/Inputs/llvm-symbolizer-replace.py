@@ -0,0 +1,57 @@
+#!/usr/bin/env python
+"""Query llvm-symbolizer while replacing one of the binaries it symbolizes.
+
+Usage: llvm-symbolizer-replace.py <llvm-symbolizer> <path> <old> <new> \
+           <old offset> <other> <other offset> <new offset> [options...]
+
+Copies <old> to <path>, or removes <path> if <old> is "-", and symbolizes
+<old offset> in <path>. Then symbolizes <other offset> in <other>, replaces
+<path> with a copy of <new> and symbolizes <new offset> in <path>. Prints the
+three answers.
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+
+
+def query(symbolizer, module, offset):
+    symbolizer.stdin.write(('%s %s\n' % (module, offset)).encode())
+    symbolizer.stdin.flush()
+    # Every answer ends with an empty line.
+    while True:
+        line = symbolizer.stdout.readline().decode()
+        if not line:
+            sys.exit('llvm-symbolizer exited')
+        sys.stdout.write(line)
+        if line == '\n':
+            return
+
+
+def replace(path, source):
+    # Write a new file rather than overwriting the one llvm-symbolizer may
+    # still have mapped.
+    if os.path.exists(path):
+        os.remove(path)
+    if source != '-':
+        shutil.copyfile(source, path)
+
+
+def main():
+    (tool, path, old, new, old_offset, other, other_offset,
+     new_offset) = sys.argv[1:9]
+    replace(path, old)
+    symbolizer = subprocess.Popen([tool] + sys.argv[9:],
+                                  stdin=subprocess.PIPE,
+                                  stdout=subprocess.PIPE)
+    query(symbolizer, path, old_offset)
+    query(symbolizer, other, other_offset)
+    replace(path, new)
+    query(symbolizer, path, new_offset)
+    symbolizer.stdin.close()
+    sys.exit(symbolizer.wait())
+
+
+if __name__ == '__main__':
+    main()
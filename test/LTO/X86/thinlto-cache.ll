@@ -0,0 +1,49 @@
+; RUN: llvm-as -function-summary -o %t1.bc %s
+; RUN: llvm-as -function-summary -o %t2.bc %p/Inputs/thinlto-codegen.ll
+; RUN: rm -rf %t.cache
+
+; The first link populates the cache with one entry per module.
+; RUN: llvm-lto -thinlto-codegen -thinlto-cache-dir %t.cache -filetype=asm \
+; RUN:   -o %t.s %t1.bc %t2.bc
+; RUN: ls %t.cache | count 2
+
+; The second one reuses them and produces the same objects.
+; RUN: llvm-lto -thinlto-codegen -thinlto-cache-dir %t.cache -filetype=asm \
+; RUN:   -o %t.cached.s %t1.bc %t2.bc
+; RUN: ls %t.cache | count 2
+; RUN: cmp %t.s.0 %t.cached.s.0
+; RUN: cmp %t.s.1 %t.cached.s.1
+
+; Changing the code generation options changes the keys.
+; RUN: llvm-lto -thinlto-codegen -thinlto-cache-dir %t.cache -filetype=asm \
+; RUN:   -O0 -o %t.O0.s %t1.bc %t2.bc
+; RUN: ls %t.cache | count 4
+
+; So do the options of the backends, which TargetOptions does not cover.
+; RUN: llvm-lto -thinlto-codegen -thinlto-cache-dir %t.cache -filetype=asm \
+; RUN:   -x86-asm-syntax=intel -o %t.intel.s %t1.bc %t2.bc
+; RUN: ls %t.cache | count 6
+; RUN: FileCheck --check-prefix=INTEL %s < %t.intel.s.0
+
+; And the reciprocal estimates, which TargetOptions only holds in opaque form.
+; RUN: llvm-lto -thinlto-codegen -thinlto-cache-dir %t.cache -filetype=asm \
+; RUN:   -recip=divf -o %t.recip.s %t1.bc %t2.bc
+; RUN: ls %t.cache | count 8
+
+; Where the objects are written to and how many threads write them do not.
+; RUN: llvm-lto -thinlto-codegen -thinlto-cache-dir %t.cache -filetype=asm \
+; RUN:   -j 2 -o %t.j2.s %t1.bc %t2.bc
+; RUN: ls %t.cache | count 8
+; RUN: cmp %t.s.0 %t.j2.s.0
+
+; INTEL: .intel_syntax noprefix
+; INTEL: mov eax, 42
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @caller() {
+  %r = call i32 @callee()
+  ret i32 %r
+}
+
+declare i32 @callee()
@@ -0,0 +1,34 @@
+; RUN: llvm-as -function-summary -o %t1.bc %s
+; RUN: llvm-as -function-summary -o %t2.bc %p/Inputs/thinlto-codegen.ll
+; RUN: llvm-lto -thinlto-codegen -j2 -filetype=asm -o %t.s %t1.bc %t2.bc
+; RUN: FileCheck --check-prefix=CHECK0 %s < %t.s.0
+; RUN: FileCheck --check-prefix=CHECK1 %s < %t.s.1
+
+; RUN: not llvm-lto -thinlto-codegen %t1.bc %t2.bc 2>&1 \
+; RUN:   | FileCheck --check-prefix=NOOUTPUT %s
+; NOOUTPUT: -thinlto-codegen must be specified together with -o
+
+; Errors of the backends are reported once all of them are done, in input
+; order.
+; RUN: not llvm-lto -thinlto-codegen -j2 -o %t.missing/out %t1.bc %t2.bc 2>&1 \
+; RUN:   | FileCheck --check-prefix=BADOUTPUT %s
+; BADOUTPUT: error opening the file '{{.*}}.missing/out.0'
+; BADOUTPUT: error opening the file '{{.*}}.missing/out.1'
+
+target triple = "x86_64-unknown-linux-gnu"
+
+; The body of @callee is imported from the second module and inlined, while the
+; first module remains the only one defining @caller.
+; CHECK0-LABEL: caller:
+; CHECK0-NOT: callee
+; CHECK0: movl $42, %eax
+; CHECK0-NOT: callee:
+define i32 @caller() {
+  %r = call i32 @callee()
+  ret i32 %r
+}
+
+declare i32 @callee()
+
+; CHECK1-NOT: caller:
+; CHECK1: callee:
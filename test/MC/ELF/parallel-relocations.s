@@ -0,0 +1,27 @@
+// Encoding many relocation sections on several threads must produce the same
+// object as the serial writer.
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.serial.o
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu \
+// RUN:   -object-writer-threads=4 %s -o %t.parallel.o
+// RUN: cmp %t.serial.o %t.parallel.o
+// RUN: llvm-readobj -r %t.parallel.o | FileCheck %s
+
+// CHECK:      Section ({{[0-9]+}}) .rela.text.0 {
+// CHECK-NEXT:   0x1 R_X86_64_PC32 foo 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   0x5 R_X86_64_64 bar 0x0
+// CHECK-NEXT: }
+// CHECK:      Section ({{[0-9]+}}) .rela.text.299 {
+// CHECK-NEXT:   0x1 R_X86_64_PC32 foo 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   0x5 R_X86_64_64 bar 0x0
+// CHECK-NEXT: }
+
+// Enough sections with relocations to take the parallel path.
+        .macro func
+        .section .text.\@,"ax",@progbits
+        call foo
+        .quad bar
+        .endm
+
+        .rept 300
+        func
+        .endr
@@ -0,0 +1,71 @@
+; RUN: opt -S -codegenprepare -cgp-region-sinking < %s | FileCheck %s
+; RUN: opt -S -codegenprepare < %s | FileCheck %s --check-prefix=DEFAULT
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; The multiply and the add only feed the return in %then, which can only be
+; reached from %entry: sink them there, so that instruction selection can fold
+; them together.
+; CHECK-LABEL: @sink(
+; CHECK: entry:
+; CHECK-NEXT: icmp
+; CHECK-NEXT: br
+; CHECK: then:
+; CHECK-NEXT: %scaled = mul i32 %a, 5
+; CHECK-NEXT: %sum = add i32 %scaled, %b
+; CHECK-NEXT: ret i32 %sum
+; DEFAULT-LABEL: @sink(
+; DEFAULT: entry:
+; DEFAULT-NEXT: %scaled = mul i32 %a, 5
+define i32 @sink(i32 %a, i32 %b, i32 %v) {
+entry:
+  %scaled = mul i32 %a, 5
+  %sum = add i32 %scaled, %b
+  %c = icmp eq i32 %v, 0
+  br i1 %c, label %exit, label %then
+
+then:
+  ret i32 %sum
+
+exit:
+  ret i32 0
+}
+
+; %join has two predecessors, so it may run more often than either of them:
+; leave the computation where it is.
+; CHECK-LABEL: @no_sink_merge(
+; CHECK: entry:
+; CHECK-NEXT: %sum = add i32 %a, %b
+define i32 @no_sink_merge(i32 %a, i32 %b, i1 %c) {
+entry:
+  %sum = add i32 %a, %b
+  br i1 %c, label %left, label %join
+
+left:
+  call void @g()
+  br label %join
+
+join:
+  %r = mul i32 %sum, 3
+  ret i32 %r
+}
+
+; Loads are not moved.
+; CHECK-LABEL: @no_sink_load(
+; CHECK: entry:
+; CHECK-NEXT: load
+define i32 @no_sink_load(i32* %p, i1 %c) {
+entry:
+  %l = load i32, i32* %p
+  br i1 %c, label %then, label %exit
+
+then:
+  %r = add i32 %l, 1
+  ret i32 %r
+
+exit:
+  ret i32 0
+}
+
+declare void @g()
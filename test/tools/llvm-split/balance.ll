@@ -0,0 +1,37 @@
+; RUN: llvm-split -preserve-locals -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; The largest functions are placed first, each one in the partition with the
+; fewest instructions so far: @f4 and @f1 (5 instructions) end up together, and
+; so do @f3 and @f2 (5 instructions).
+
+; CHECK0: define i32 @f1(i32 %x)
+; CHECK1: declare i32 @f1(i32)
+define i32 @f1(i32 %x) {
+  ret i32 %x
+}
+
+; CHECK0: declare i32 @f2(i32)
+; CHECK1: define i32 @f2(i32 %x)
+define i32 @f2(i32 %x) {
+  %a = add i32 %x, 1
+  ret i32 %a
+}
+
+; CHECK0: declare i32 @f3(i32)
+; CHECK1: define i32 @f3(i32 %x)
+define i32 @f3(i32 %x) {
+  %a = add i32 %x, 1
+  %b = add i32 %a, 2
+  ret i32 %b
+}
+
+; CHECK0: define i32 @f4(i32 %x)
+; CHECK1: declare i32 @f4(i32)
+define i32 @f4(i32 %x) {
+  %a = add i32 %x, 1
+  %b = add i32 %a, 2
+  %c = add i32 %b, 3
+  ret i32 %c
+}
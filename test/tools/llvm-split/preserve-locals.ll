@@ -0,0 +1,47 @@
+; RUN: llvm-split -preserve-locals -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; @local is kept internal and lands in the partition of all of its users, and
+; so does @localfn, which is only referenced through a constant expression.
+
+; CHECK0: @local = external global i32
+; CHECK1: @local = internal global i32 0
+@local = internal global i32 0
+
+; CHECK0: @table = external global
+; CHECK1: @table = global [1 x i8*] [i8* bitcast (void ()* @localfn to i8*)]
+@table = global [1 x i8*] [i8* bitcast (void ()* @localfn to i8*)]
+
+; CHECK0: define i32 @big(i32 %x)
+; CHECK1: declare i32 @big(i32)
+define i32 @big(i32 %x) {
+  %a = add i32 %x, 1
+  %b = add i32 %a, 2
+  %c = add i32 %b, 3
+  %d = add i32 %c, 4
+  %e = add i32 %d, 5
+  %f = add i32 %e, 6
+  %g = add i32 %f, 7
+  ret i32 %g
+}
+
+; CHECK0: declare void @localfn()
+; CHECK1: define internal void @localfn()
+define internal void @localfn() {
+  ret void
+}
+
+; CHECK0: declare i32 @getlocal()
+; CHECK1: define i32 @getlocal()
+define i32 @getlocal() {
+  %v = load i32, i32* @local
+  ret i32 %v
+}
+
+; CHECK0: declare void @setlocal(i32)
+; CHECK1: define void @setlocal(i32 %v)
+define void @setlocal(i32 %v) {
+  store i32 %v, i32* @local
+  ret void
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+"""Start llvm-symbolizer in server mode and query it.
+
+Usage: server-client.py <llvm-symbolizer> <socket> <input> [options...]
+
+The first client sends the requests of <input> and disconnects without reading
+the answers. The second one sends them again and prints the answers. The
+server must survive the first client and still be running afterwards.
+"""
+
+import os
+import signal
+import socket
+import subprocess
+import sys
+import time
+
+
+def connect(path, server):
+    for _ in range(200):
+        if server.poll() is not None:
+            sys.exit('server exited with %d' % server.returncode)
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            s.connect(path)
+            return s
+        except socket.error:
+            s.close()
+            time.sleep(0.05)
+    sys.exit('cannot connect to ' + path)
+
+
+def main():
+    symbolizer, path, input_path = sys.argv[1:4]
+    with open(input_path, 'rb') as f:
+        requests = f.read()
+
+    # Socket paths are short, so refer to the socket relative to its directory.
+    os.chdir(os.path.dirname(os.path.abspath(path)))
+    path = os.path.basename(path)
+    if os.path.exists(path):
+        os.unlink(path)
+    # Python 2 ignores SIGPIPE and lets its children inherit that. Give the
+    # server the default disposition, which terminates it.
+    server = subprocess.Popen(
+        [symbolizer, '-server=' + path] + sys.argv[4:],
+        preexec_fn=lambda: signal.signal(signal.SIGPIPE, signal.SIG_DFL))
+    try:
+        client = connect(path, server)
+        client.sendall(requests * 20000)
+        client.close()
+
+        client = connect(path, server)
+        client.sendall(requests)
+        client.shutdown(socket.SHUT_WR)
+        answers = b''
+        while True:
+            try:
+                data = client.recv(4096)
+            except socket.error:
+                break
+            if not data:
+                break
+            answers += data
+        client.close()
+
+        sys.stdout.write(answers.decode())
+        sys.stdout.flush()
+        if server.poll() is not None:
+            sys.exit('server exited with %d' % server.returncode)
+    finally:
+        if server.poll() is None:
+            server.kill()
+            server.wait()
+
+
+if __name__ == '__main__':
+    main()
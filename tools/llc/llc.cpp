@@ -15,12 +15,14 @@
 
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
 #include "llvm/CodeGen/MIRParser/MIRParser.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
@@ -103,6 +105,11 @@ static cl::opt<bool>
                           "manager and verify the result is the same."),
                  cl::init(false));
 
+static cl::opt<unsigned> SplitCodeGen(
+    "split-codegen", cl::init(1), cl::value_desc("N"),
+    cl::desc("Split the module into N partitions generated on separate "
+             "threads, written to <output>.0 to <output>.N-1"));
+
 static int compileModule(char **, LLVMContext &);
 
 static std::unique_ptr<tool_output_file>
@@ -213,6 +220,56 @@ int main(int argc, char **argv) {
   return 0;
 }
 
+// Generate code for M with the -split-codegen mode: the module is split into
+// partitions balanced by instruction count, and the whole code generation
+// pipeline of every partition runs on its own thread and in its own context.
+// Linking the outputs together is equivalent to the output of a single
+// partition.
+static int compileModuleInParallel(char **argv, std::unique_ptr<Module> M,
+                                   bool IsMIR, StringRef CPUStr,
+                                   StringRef FeaturesStr,
+                                   const TargetOptions &Options,
+                                   CodeGenOpt::Level OLvl) {
+  if (OutputFilename.empty() || OutputFilename == "-") {
+    errs() << argv[0] << ": -split-codegen requires an output file name\n";
+    return 1;
+  }
+  if (IsMIR || !RunPass.empty() || !StartAfter.empty() || !StopAfter.empty() ||
+      CompileTwice) {
+    errs() << argv[0] << ": -split-codegen only supports generating code for "
+                         "IR modules with the whole pipeline\n";
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<tool_output_file>> Outs;
+  std::vector<raw_pwrite_stream *> OSs;
+  sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
+  if (FileType == TargetMachine::CGFT_AssemblyFile)
+    OpenFlags |= sys::fs::F_Text;
+  for (unsigned I = 0; I != SplitCodeGen; ++I) {
+    std::error_code EC;
+    std::string PartitionFilename = OutputFilename + "." + utostr(I);
+    Outs.push_back(
+        llvm::make_unique<tool_output_file>(PartitionFilename, EC, OpenFlags));
+    if (EC) {
+      errs() << argv[0] << ": " << PartitionFilename << ": " << EC.message()
+             << '\n';
+      return 1;
+    }
+    OSs.push_back(&Outs.back()->os());
+  }
+
+  // Before executing passes, print the final values of the LLVM options.
+  cl::PrintOptionValues();
+
+  splitCodeGen(std::move(M), OSs, CPUStr, FeaturesStr, Options, RelocModel,
+               CMModel, OLvl, FileType);
+
+  for (auto &Out : Outs)
+    Out->keep();
+  return 0;
+}
+
 static int compileModule(char **argv, LLVMContext &Context) {
   // Load the module to be compiled...
   SMDiagnostic Err;
@@ -302,6 +359,15 @@ static int compileModule(char **argv, LLVMContext &Context) {
   if (FloatABIForCalls != FloatABI::Default)
     Options.FloatABIType = FloatABIForCalls;
 
+  if (SplitCodeGen > 1) {
+    // The partitions are generated by their own target machines, which expect
+    // the same data layout and function attributes as the serial path sets.
+    M->setDataLayout(Target->createDataLayout());
+    setFunctionAttributes(CPUStr, FeaturesStr, *M);
+    return compileModuleInParallel(argv, std::move(M), MIR != nullptr, CPUStr,
+                                   FeaturesStr, Options, OLvl);
+  }
+
   // Figure out where we are going to send the output.
   std::unique_ptr<tool_output_file> Out =
       GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]);
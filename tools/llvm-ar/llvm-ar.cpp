@@ -12,6 +12,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/LLVMContext.h"
@@ -31,11 +32,16 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <deque>
 #include <memory>
+#include <thread>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
 #include <unistd.h>
@@ -64,6 +70,14 @@ static void failIfError(std::error_code EC, Twine Context = "") {
   fail(Context + ": " + EC.message());
 }
 
+// The number of threads used to read and extract members: one per core, or
+// none when LLVM is built without thread support.
+static unsigned getThreadCount() {
+  if (!llvm_is_multithreaded())
+    return 0;
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
 // llvm-ar/llvm-ranlib remaining positional arguments.
 static cl::list<std::string>
     RestOfArgs(cl::Positional, cl::ZeroOrMore,
@@ -81,6 +95,11 @@ static cl::opt<Format>
                          clEnumValN(GNU, "gnu", "gnu"),
                          clEnumValN(BSD, "bsd", "bsd"), clEnumValEnd));
 
+static cl::opt<bool> ReuseSymtab(
+    "reuse-symtab",
+    cl::desc("Copy the symbol table entries of the members kept from the "
+             "existing archive instead of reading them again"));
+
 static std::string Options;
 
 // Provide additional help output explaining the operations and modifiers of
@@ -339,16 +358,18 @@ static void doDisplayTable(StringRef Name, const object::Archive::Child &C) {
 }
 
 // Implement the 'x' operation. This function extracts files back to the file
-// system.
-static void doExtract(StringRef Name, const object::Archive::Child &C) {
+// system. It runs on the extraction pool, so it returns its errors to the main
+// thread instead of exiting.
+static std::error_code doExtract(StringRef Name,
+                                 const object::Archive::Child &C) {
   // Retain the original mode.
   sys::fs::perms Mode = C.getAccessMode();
   SmallString<128> Storage = Name;
 
   int FD;
-  failIfError(
-      sys::fs::openFileForWrite(Storage.c_str(), FD, sys::fs::F_None, Mode),
-      Storage.c_str());
+  if (std::error_code EC =
+          sys::fs::openFileForWrite(Storage.c_str(), FD, sys::fs::F_None, Mode))
+    return EC;
 
   {
     raw_fd_ostream file(FD, false);
@@ -362,12 +383,13 @@ static void doExtract(StringRef Name, const object::Archive::Child &C) {
 
   // If we're supposed to retain the original modification times, etc. do so
   // now.
+  std::error_code EC;
   if (OriginalDates)
-    failIfError(
-        sys::fs::setLastModificationAndAccessTime(FD, C.getLastModified()));
+    EC = sys::fs::setLastModificationAndAccessTime(FD, C.getLastModified());
 
-  if (close(FD))
-    fail("Could not close the file");
+  if (close(FD) && !EC)
+    EC = std::error_code(errno, std::generic_category());
+  return EC;
 }
 
 static bool shouldCreateArchive(ArchiveOperation Op) {
@@ -393,6 +415,23 @@ static void performReadOperation(ArchiveOperation Operation,
   if (Operation == Extract && OldArchive->isThin())
     fail("extracting from a thin archive is not supported");
 
+  // Members are extracted in parallel: they are written straight from the
+  // mapped archive to distinct files. A member whose name was already seen
+  // must overwrite the earlier one, so wait for the pending extractions first.
+  // Each extraction stores its error in its own element of ExtractErrors,
+  // which are reported in member order once the pool is idle.
+  std::unique_ptr<ThreadPool> ExtractPool;
+  StringSet<> PendingNames;
+  std::deque<std::pair<StringRef, std::error_code>> ExtractErrors;
+  if (Operation == Extract)
+    ExtractPool.reset(new ThreadPool(getThreadCount()));
+  auto WaitForExtractions = [&] {
+    ExtractPool->wait();
+    for (const auto &E : ExtractErrors)
+      failIfError(E.second, E.first);
+    ExtractErrors.clear();
+  };
+
   bool Filter = !Members.empty();
   for (auto &ChildOrErr : OldArchive->children()) {
     failIfError(ChildOrErr.getError());
@@ -419,10 +458,19 @@ static void performReadOperation(ArchiveOperation Operation,
       doDisplayTable(Name, C);
       break;
     case Extract:
-      doExtract(Name, C);
+      if (!PendingNames.insert(Name).second) {
+        WaitForExtractions();
+        PendingNames.clear();
+        PendingNames.insert(Name);
+      }
+      ExtractErrors.emplace_back(Name, std::error_code());
+      std::error_code &EC = ExtractErrors.back().second;
+      ExtractPool->async([Name, C, &EC] { EC = doExtract(Name, C); });
       break;
     }
   }
+  if (ExtractPool)
+    WaitForExtractions();
   if (Members.empty())
     return;
   for (StringRef Name : Members)
@@ -599,15 +647,17 @@ performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
     break;
   }
   if (NewMembersP) {
-    std::pair<StringRef, std::error_code> Result = writeArchive(
-        ArchiveName, *NewMembersP, Symtab, Kind, Deterministic, Thin);
+    std::pair<StringRef, std::error_code> Result =
+        writeArchive(ArchiveName, *NewMembersP, Symtab, Kind, Deterministic,
+                     Thin, ReuseSymtab, getThreadCount());
     failIfError(Result.second, Result.first);
     return;
   }
   std::vector<NewArchiveIterator> NewMembers =
       computeNewArchiveMembers(Operation, OldArchive);
-  auto Result =
-      writeArchive(ArchiveName, NewMembers, Symtab, Kind, Deterministic, Thin);
+  auto Result = writeArchive(ArchiveName, NewMembers, Symtab, Kind,
+                             Deterministic, Thin, ReuseSymtab,
+                             getThreadCount());
   failIfError(Result.second, Result.first);
 }
 
@@ -8,26 +8,44 @@
 //===----------------------------------------------------------------------===//
 //
 // This program takes in a list of bitcode files, links them, performs link-time
-// optimization, and outputs an object file.
+// optimization, and outputs an object file. With -thinlto-codegen it instead
+// runs the ThinLTO backends, optimizing and generating code for every input
+// independently after importing functions based on the combined index.
 //
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IRReader/IRReader.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
+#include "llvm/LTO/LTOObjectCache.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/Object/FunctionIndexObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include <list>
 
 using namespace llvm;
@@ -64,6 +82,18 @@ static cl::opt<bool>
     ThinLTO("thinlto", cl::init(false),
             cl::desc("Only write combined global index for ThinLTO backends"));
 
+static cl::opt<bool> ThinLTOCodeGen(
+    "thinlto-codegen", cl::init(false),
+    cl::desc("Run the ThinLTO backends: import functions into every input "
+             "based on the combined index, then optimize and generate code "
+             "for each of them independently"));
+
+static cl::opt<std::string> ThinLTOCacheDir(
+    "thinlto-cache-dir",
+    cl::desc("Reuse the objects generated by -thinlto-codegen from this "
+             "directory when their inputs and options did not change"),
+    cl::value_desc("directory"));
+
 static cl::opt<bool>
 SaveModuleFile("save-merged-module", cl::init(false),
                cl::desc("Write merged LTO module to file before CodeGen"));
@@ -125,8 +155,7 @@ static void handleDiagnostics(lto_codegen_diagnostic_severity_t Severity,
 }
 
 static std::string CurrentActivity;
-static void diagnosticHandler(const DiagnosticInfo &DI) {
-  raw_ostream &OS = errs();
+static void printDiagnostic(const DiagnosticInfo &DI, raw_ostream &OS) {
   OS << "llvm-lto: ";
   switch (DI.getSeverity()) {
   case DS_Error:
@@ -149,7 +178,10 @@ static void diagnosticHandler(const DiagnosticInfo &DI) {
   DiagnosticPrinterRawOStream DP(OS);
   DI.print(DP);
   OS << '\n';
+}
 
+static void diagnosticHandler(const DiagnosticInfo &DI) {
+  printDiagnostic(DI, errs());
   if (DI.getSeverity() == DS_Error)
     exit(1);
 }
@@ -207,12 +239,8 @@ static void listSymbols(const TargetOptions &Options) {
   }
 }
 
-/// Create a combined index file from the input IR files and write it.
-///
-/// This is meant to enable testing of ThinLTO combined index generation,
-/// currently available via the gold plugin via -thinlto.
-static void createCombinedFunctionIndex() {
-  FunctionInfoIndex CombinedIndex;
+/// Build the combined function index of the input IR files.
+static void buildCombinedFunctionIndex(FunctionInfoIndex &CombinedIndex) {
   uint64_t NextModuleId = 0;
   for (auto &Filename : InputFilenames) {
     CurrentActivity = "loading file '" + Filename + "'";
@@ -225,6 +253,15 @@ static void createCombinedFunctionIndex() {
       continue;
     CombinedIndex.mergeFrom(std::move(Index), ++NextModuleId);
   }
+}
+
+/// Create a combined index file from the input IR files and write it.
+///
+/// This is meant to enable testing of ThinLTO combined index generation,
+/// currently available via the gold plugin via -thinlto.
+static void createCombinedFunctionIndex() {
+  FunctionInfoIndex CombinedIndex;
+  buildCombinedFunctionIndex(CombinedIndex);
   std::error_code EC;
   assert(!OutputFilename.empty());
   raw_fd_ostream OS(OutputFilename + ".thinlto.bc", EC,
@@ -234,6 +271,334 @@ static void createCombinedFunctionIndex() {
   OS.close();
 }
 
+/// Load the module \p Path lazily in \p Context, to import functions from it.
+///
+/// The function importer cannot recover from a module that fails to load.
+/// thinLTOCodeGen checks that every input loads before starting the backends,
+/// so a failure here means that a file changed while they were running.
+static std::unique_ptr<Module> loadModuleForImport(StringRef Path,
+                                                   LLVMContext &Context) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = getLazyIRFileModule(Path, Err, Context);
+  if (!M)
+    report_fatal_error("error loading file '" + Path +
+                       "' for import: " + Err.getMessage());
+  M->materializeMetadata();
+  UpgradeDebugInfo(*M);
+  return M;
+}
+
+/// Describe the command line \p argv for the object cache key. Besides the
+/// options of llvm-lto and CommandFlags.h, it may set any cl::opt of the
+/// backends, e.g. -enable-misched or -x86-asm-syntax. There is no generic way
+/// to read back the value of those, so they are described as spelled. Only the
+/// input files and the options naming where the outputs go are left out.
+static std::string describeCommandLine(int argc, char **argv) {
+  SmallVector<const char *, 20> Args(argv + 1, argv + argc);
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  cl::ExpandResponseFiles(Saver, cl::TokenizeGNUCommandLine, Args);
+
+  const cl::Option *Ignored[] = {&OutputFilename, &ThinLTOCacheDir,
+                                 &Parallelism};
+  StringMap<cl::Option *> &Registered = cl::getRegisteredOptions();
+  std::string Description;
+  raw_string_ostream OS(Description);
+  for (unsigned I = 0, E = Args.size(); I != E; ++I) {
+    StringRef Arg = Args[I];
+    if (!Arg.startswith("-") || Arg == "-")
+      continue;
+
+    // Prefix options such as -O2 or -j4 are followed by their value directly.
+    StringRef Name = Arg.ltrim("-").split('=').first;
+    auto OptI = Registered.find(Name);
+    bool IsPrefix = false;
+    while (OptI == Registered.end() && Name.size() > 1) {
+      Name = Name.drop_back();
+      OptI = Registered.find(Name);
+      IsPrefix = true;
+    }
+    const cl::Option *Opt = OptI == Registered.end() ? nullptr : OptI->second;
+    bool HasSeparateValue = Opt && !IsPrefix && !Arg.count('=') &&
+                            Opt->getValueExpectedFlag() == cl::ValueRequired &&
+                            I + 1 != E;
+
+    if (std::find(std::begin(Ignored), std::end(Ignored), Opt) !=
+        std::end(Ignored)) {
+      I += HasSeparateValue;
+      continue;
+    }
+    OS << ' ' << Arg;
+    if (HasSeparateValue)
+      OS << ' ' << Args[++I];
+  }
+  return OS.str();
+}
+
+/// Describe every option that affects the code generated by the ThinLTO
+/// backends, besides the target triple, for the object cache key.
+/// \p CommandLine is the description of the command line of llvm-lto.
+static std::string
+getCodeGenOptionsDescription(const TargetOptions &Options,
+                             TargetMachine::CodeGenFileType FT,
+                             StringRef CommandLine) {
+  std::string Description;
+  raw_string_ostream OS(Description);
+  OS << "-O" << OptLevel << " inline=" << !DisableInline
+     << " gvn-loadpre=" << !DisableGVNLoadPRE
+     << " vectorize=" << !DisableLTOVectorization
+     << " verify=" << !DisableVerify << " filetype=" << FT
+     << " cpu=" << getCPUStr() << " features=" << getFeaturesStr()
+     << " reloc=" << static_cast<int>(RelocModel)
+     << " code-model=" << static_cast<int>(CMModel);
+
+  // Every field of TargetOptions, in declaration order.
+  OS << " print-machineinstrs=" << Options.PrintMachineCode
+     << " fp-mad=" << Options.LessPreciseFPMADOption
+     << " unsafe-fp=" << Options.UnsafeFPMath
+     << " no-infs=" << Options.NoInfsFPMath
+     << " no-nans=" << Options.NoNaNsFPMath
+     << " sign-rounding=" << Options.HonorSignDependentRoundingFPMathOption
+     << " no-zeros-in-bss=" << Options.NoZerosInBSS
+     << " tailcallopt=" << Options.GuaranteedTailCallOpt
+     << " stack-align=" << Options.StackAlignmentOverride
+     << " fast-isel=" << Options.EnableFastISel
+     << " pie=" << Options.PositionIndependentExecutable
+     << " init-array=" << Options.UseInitArray
+     << " no-integrated-as=" << Options.DisableIntegratedAS
+     << " compress-debug-sections=" << Options.CompressDebugSections
+     << " function-sections=" << Options.FunctionSections
+     << " data-sections=" << Options.DataSections
+     << " unique-section-names=" << Options.UniqueSectionNames
+     << " trap-unreachable=" << Options.TrapUnreachable
+     << " emulated-tls=" << Options.EmulatedTLS
+     << " float-abi=" << Options.FloatABIType
+     << " fp-contract=" << Options.AllowFPOpFusion
+     << " jump-table-type=" << Options.JTType
+     << " thread-model=" << Options.ThreadModel
+     << " eabi=" << static_cast<unsigned>(Options.EABIVersion);
+  // TargetRecip cannot be inspected, describe the -recip operands it was built
+  // from instead.
+  for (const std::string &Op : ReciprocalOps)
+    OS << " recip=" << Op;
+
+  // Every field of MCTargetOptions, in declaration order.
+  const MCTargetOptions &MCOptions = Options.MCOptions;
+  OS << " asan=" << MCOptions.SanitizeAddress
+     << " relax-all=" << MCOptions.MCRelaxAll
+     << " no-exec-stack=" << MCOptions.MCNoExecStack
+     << " fatal-warnings=" << MCOptions.MCFatalWarnings
+     << " no-warn=" << MCOptions.MCNoWarn
+     << " save-temp-labels=" << MCOptions.MCSaveTempLabels
+     << " dwarf-directory=" << MCOptions.MCUseDwarfDirectory
+     << " show-mc-encoding=" << MCOptions.ShowMCEncoding
+     << " show-mc-inst=" << MCOptions.ShowMCInst
+     << " asm-verbose=" << MCOptions.AsmVerbose
+     << " dwarf-version=" << MCOptions.DwarfVersion
+     << " object-writer-threads=" << MCOptions.ObjectWriterThreads
+     << " abi=" << MCOptions.ABIName;
+
+  OS << " command-line=" << CommandLine;
+  return OS.str();
+}
+
+namespace {
+/// What a ThinLTO backend reports. The backends run on pool threads, so they
+/// neither print nor exit: thinLTOCodeGen prints the diagnostics of every
+/// backend in input order once they are all done.
+struct ThinLTOBackendResult {
+  std::string Diagnostics;
+  bool Failed = false;
+
+  void addError(const Twine &Msg) {
+    raw_string_ostream(Diagnostics) << "llvm-lto: " << Msg << '\n';
+    Failed = true;
+  }
+};
+}
+
+static void recordDiagnostic(const DiagnosticInfo &DI, void *Context) {
+  auto &Result = *static_cast<ThinLTOBackendResult *>(Context);
+  raw_string_ostream OS(Result.Diagnostics);
+  printDiagnostic(DI, OS);
+  if (DI.getSeverity() == DS_Error)
+    Result.Failed = true;
+}
+
+/// Run the ThinLTO backend for the module \p Path in a context of its own:
+/// promote the local values other modules may import, import functions from
+/// the other modules based on \p Index, optimize the result and generate code
+/// for it into \p OutputPath. Diagnostics and errors go to \p Result.
+/// \p CommandLine is the description of the command line of llvm-lto, for the
+/// object cache.
+static void runThinLTOBackend(StringRef Path, const FunctionInfoIndex &Index,
+                              StringRef OutputPath,
+                              const TargetOptions &Options,
+                              StringRef CommandLine,
+                              ThinLTOBackendResult &Result) {
+  LLVMContext Context;
+  Context.setDiagnosticHandler(recordDiagnostic, &Result, true);
+  auto DiagHandler = [&Result](const DiagnosticInfo &DI) {
+    recordDiagnostic(DI, &Result);
+  };
+
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseIRFile(Path, Err, Context);
+  if (!M) {
+    raw_string_ostream OS(Result.Diagnostics);
+    Err.print("llvm-lto", OS);
+    Result.Failed = true;
+    return;
+  }
+
+  M = renameModuleForThinLTO(M, &Index, DiagHandler);
+  if (!M || Result.Failed) {
+    Result.addError("error promoting the local values of '" + Path + "'");
+    return;
+  }
+
+  auto ModuleLoader = [&Context](StringRef Identifier) {
+    return loadModuleForImport(Identifier, Context);
+  };
+  FunctionImporter Importer(Index, DiagHandler, ModuleLoader);
+  Importer.importFunctions(*M);
+  if (Result.Failed)
+    return;
+
+  Triple TheTriple(M->getTargetTriple());
+  if (TheTriple.getTriple().empty())
+    TheTriple.setTriple(sys::getDefaultTargetTriple());
+  std::string ErrMsg;
+  const Target *TheTarget =
+      TargetRegistry::lookupTarget(TheTriple.getTriple(), ErrMsg);
+  if (!TheTarget) {
+    Result.addError("error selecting the target for '" + Path + "': " +
+                    ErrMsg);
+    return;
+  }
+
+  CodeGenOpt::Level CGOptLevel;
+  switch (OptLevel) {
+  case '0':
+    CGOptLevel = CodeGenOpt::None;
+    break;
+  case '1':
+    CGOptLevel = CodeGenOpt::Less;
+    break;
+  case '2':
+    CGOptLevel = CodeGenOpt::Default;
+    break;
+  default:
+    CGOptLevel = CodeGenOpt::Aggressive;
+    break;
+  }
+  std::unique_ptr<TargetMachine> TM(TheTarget->createTargetMachine(
+      TheTriple.getTriple(), getCPUStr(), getFeaturesStr(), Options,
+      RelocModel, CMModel, CGOptLevel));
+  M->setDataLayout(TM->createDataLayout());
+
+  TargetMachine::CodeGenFileType FT = TargetMachine::CGFT_ObjectFile;
+  if (FileType.getNumOccurrences())
+    FT = FileType;
+
+  // Returns null on errors, so that a broken object is never cached.
+  auto Generate = [&]() -> std::unique_ptr<MemoryBuffer> {
+    legacy::PassManager PM;
+    PM.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
+
+    PassManagerBuilder PMB;
+    PMB.DisableGVNLoadPRE = DisableGVNLoadPRE;
+    PMB.LoopVectorize = !DisableLTOVectorization;
+    PMB.SLPVectorize = !DisableLTOVectorization;
+    if (!DisableInline)
+      PMB.Inliner = createFunctionInliningPass();
+    PMB.LibraryInfo = new TargetLibraryInfoImpl(TheTriple);
+    PMB.OptLevel = OptLevel - '0';
+    PMB.populateModulePassManager(PM);
+
+    SmallVector<char, 0> Object;
+    raw_svector_ostream OS(Object);
+    if (TM->addPassesToEmitFile(PM, OS, FT, DisableVerify)) {
+      Result.addError("target does not support generation of this file type");
+      return nullptr;
+    }
+
+    PM.run(*M);
+    if (Result.Failed)
+      return nullptr;
+    return MemoryBuffer::getMemBufferCopy(StringRef(Object.data(),
+                                                    Object.size()));
+  };
+
+  // The key is computed once importing is done, so that it covers the bodies
+  // of the imported functions as well as the module itself.
+  std::unique_ptr<MemoryBuffer> Object;
+  if (ThinLTOCacheDir.empty()) {
+    Object = Generate();
+  } else {
+    LTOObjectCache Cache(ThinLTOCacheDir);
+    std::string Key = LTOObjectCache::computeKey(
+        *M, getCodeGenOptionsDescription(Options, FT, CommandLine));
+    Object = Cache.getOrGenerate(Key, Generate);
+  }
+  if (!Object)
+    return;
+
+  std::error_code EC;
+  tool_output_file Out(OutputPath, EC, sys::fs::F_None);
+  if (EC) {
+    Result.addError("error opening the file '" + OutputPath + "': " +
+                    EC.message());
+    return;
+  }
+  Out.os() << Object->getBuffer();
+  Out.keep();
+}
+
+/// Run the ThinLTO backends of all the input files on -j threads. The object
+/// file for the N-th input is written to <output>.N. \p CommandLine is the
+/// description of the command line of llvm-lto, for the object cache.
+static void thinLTOCodeGen(const TargetOptions &Options,
+                           StringRef CommandLine) {
+  if (OutputFilename.empty())
+    error("-thinlto-codegen must be specified together with -o");
+
+  FunctionInfoIndex CombinedIndex;
+  buildCombinedFunctionIndex(CombinedIndex);
+
+  // The backends import from any of the inputs, and the importer cannot
+  // recover from a module that fails to load, so check that they all load
+  // here, where an error can still be reported.
+  for (auto &Filename : InputFilenames) {
+    LLVMContext Context;
+    SMDiagnostic Err;
+    if (!getLazyIRFileModule(Filename, Err, Context)) {
+      Err.print("llvm-lto", errs());
+      exit(1);
+    }
+  }
+
+  std::vector<ThinLTOBackendResult> Results(InputFilenames.size());
+  ThreadPool Pool(Parallelism);
+  for (unsigned I = 0, E = InputFilenames.size(); I != E; ++I) {
+    std::string OutputPath = OutputFilename + "." + utostr(I);
+    Pool.async([&CombinedIndex, &Options, CommandLine, &Results, I,
+                OutputPath]() {
+      runThinLTOBackend(InputFilenames[I], CombinedIndex, OutputPath, Options,
+                        CommandLine, Results[I]);
+    });
+  }
+  Pool.wait();
+
+  bool Failed = false;
+  for (const ThinLTOBackendResult &Result : Results) {
+    errs() << Result.Diagnostics;
+    Failed |= Result.Failed;
+  }
+  if (Failed)
+    exit(1);
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -264,6 +629,11 @@ int main(int argc, char **argv) {
     return 0;
   }
 
+  if (ThinLTOCodeGen) {
+    thinLTOCodeGen(Options, describeCommandLine(argc, argv));
+    return 0;
+  }
+
   unsigned BaseArg = 0;
 
   LLVMContext Context;
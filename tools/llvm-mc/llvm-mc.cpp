@@ -19,6 +19,7 @@
 #include "llvm/MC/MCInstPrinter.h"
 #include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCObjectStreamer.h"
 #include "llvm/MC/MCParser/AsmLexer.h"
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCSectionMachO.h"
@@ -514,6 +515,8 @@ int main(int argc, char **argv) {
     Str.reset(TheTarget->createMCObjectStreamer(TheTriple, Ctx, *MAB, *OS, CE,
                                                 *STI, RelaxAll,
                                                 /*DWARFMustBeAtTheEnd*/ false));
+    static_cast<MCObjectStreamer &>(*Str).getAssembler().setThreadCount(
+        MCOptions.ObjectWriterThreads);
     if (NoExecStack)
       Str->InitSections(true);
   }
@@ -16,6 +16,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/DebugInfo/Symbolize/DIPrinter.h"
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 #include "llvm/Support/COM.h"
@@ -26,10 +27,22 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
 #include <string>
+#include <thread>
+
+#ifdef LLVM_ON_UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 using namespace llvm;
 using namespace symbolize;
@@ -82,6 +95,27 @@ static cl::opt<bool>
     ClPrettyPrint("pretty-print", cl::init(false),
                   cl::desc("Make the output more human friendly"));
 
+static cl::opt<std::string>
+    ClServerSocket("server", cl::init(""),
+                   cl::desc("Serve requests on the Unix domain socket at this "
+                            "path instead of reading them from stdin"));
+
+static cl::opt<unsigned>
+    ClServerThreads("server-threads", cl::init(0),
+                    cl::desc("Number of clients served concurrently in server "
+                             "mode (0 = number of cores)"));
+
+static cl::opt<unsigned>
+    ClDwarfThreads("dwarf-threads", cl::init(1),
+                   cl::desc("Number of threads used to index the DWARF units "
+                            "of each module"));
+
+static cl::opt<unsigned long long>
+    ClMaxCacheSize("max-cache-size", cl::init(0),
+                   cl::desc("Evict the least recently used modules once the "
+                            "cached debug information exceeds this many "
+                            "bytes (0 = unlimited)"));
+
 static bool error(std::error_code ec) {
   if (!ec)
     return false;
@@ -89,18 +123,14 @@ static bool error(std::error_code ec) {
   return true;
 }
 
-static bool parseCommand(bool &IsData, std::string &ModuleName,
-                         uint64_t &ModuleOffset) {
+static bool parseCommand(const char *InputString, bool &IsData,
+                         std::string &ModuleName, uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
   const char *kCodeCmd = "CODE ";
-  const int kMaxInputStringLength = 1024;
   const char kDelimiters[] = " \n";
-  char InputString[kMaxInputStringLength];
-  if (!fgets(InputString, sizeof(InputString), stdin))
-    return false;
   IsData = false;
   ModuleName = "";
-  char *pos = InputString;
+  const char *pos = InputString;
   if (strncmp(pos, kDataCmd, strlen(kDataCmd)) == 0) {
     IsData = true;
     pos += strlen(kDataCmd);
@@ -117,7 +147,7 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
     if (*pos == '"' || *pos == '\'') {
       char quote = *pos;
       pos++;
-      char *end = strchr(pos, quote);
+      const char *end = strchr(pos, quote);
       if (!end)
         return false;
       ModuleName = std::string(pos, end - pos);
@@ -136,6 +166,154 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
   return !StringRef(pos, offset_length).getAsInteger(0, ModuleOffset);
 }
 
+// Symbolize the request in InputString and print the result to OS. Returns
+// false if the request is malformed.
+static bool symbolizeInput(const char *InputString, LLVMSymbolizer &Symbolizer,
+                           raw_ostream &OS) {
+  bool IsData = false;
+  std::string ModuleName;
+  uint64_t ModuleOffset;
+  if (!parseCommand(InputString, IsData, ModuleName, ModuleOffset))
+    return false;
+
+  DIPrinter Printer(OS, ClPrintFunctions != FunctionNameKind::None,
+                    ClPrettyPrint);
+  if (ClPrintAddress) {
+    OS << "0x";
+    OS.write_hex(ModuleOffset);
+    StringRef Delimiter = (ClPrettyPrint == true) ? ": " : "\n";
+    OS << Delimiter;
+  }
+  if (IsData) {
+    auto ResOrErr = Symbolizer.symbolizeData(ModuleName, ModuleOffset);
+    Printer << (error(ResOrErr.getError()) ? DIGlobal() : ResOrErr.get());
+  } else if (ClPrintInlining) {
+    auto ResOrErr = Symbolizer.symbolizeInlinedCode(ModuleName, ModuleOffset);
+    Printer << (error(ResOrErr.getError()) ? DIInliningInfo()
+                                           : ResOrErr.get());
+  } else {
+    auto ResOrErr = Symbolizer.symbolizeCode(ModuleName, ModuleOffset);
+    Printer << (error(ResOrErr.getError()) ? DILineInfo() : ResOrErr.get());
+  }
+  OS << "\n";
+  return true;
+}
+
+#ifdef LLVM_ON_UNIX
+static bool writeAll(int FD, StringRef Data) {
+  while (!Data.empty()) {
+    ssize_t Written = ::write(FD, Data.data(), Data.size());
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    Data = Data.drop_front(Written);
+  }
+  return true;
+}
+
+// Serve the requests of one client until it closes the connection. Every
+// chunk of complete lines received is answered as one batch, which only takes
+// the symbolizer lock once.
+static void serveClient(int FD, LLVMSymbolizer &Symbolizer,
+                        std::mutex &SymbolizerLock) {
+  std::string Pending;
+  char Buffer[4096];
+  bool Done = false;
+  while (!Done) {
+    ssize_t Read = ::read(FD, Buffer, sizeof(Buffer));
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      break;
+    Pending.append(Buffer, Read);
+    size_t BatchEnd = Pending.rfind('\n');
+    if (BatchEnd == std::string::npos)
+      continue;
+
+    std::string Response;
+    {
+      raw_string_ostream OS(Response);
+      std::lock_guard<std::mutex> Guard(SymbolizerLock);
+      StringRef Batch(Pending.data(), BatchEnd + 1);
+      while (!Batch.empty()) {
+        size_t LineEnd = Batch.find('\n');
+        std::string Line = Batch.substr(0, LineEnd + 1);
+        Batch = Batch.substr(LineEnd + 1);
+        if (!symbolizeInput(Line.c_str(), Symbolizer, OS)) {
+          Done = true;
+          break;
+        }
+      }
+    }
+    Pending.erase(0, BatchEnd + 1);
+    if (!writeAll(FD, Response))
+      break;
+  }
+  ::close(FD);
+}
+
+static int runServer(LLVMSymbolizer &Symbolizer) {
+  sockaddr_un Addr;
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (ClServerSocket.size() >= sizeof(Addr.sun_path)) {
+    errs() << "LLVMSymbolizer: socket path is too long: " << ClServerSocket
+           << "\n";
+    return 1;
+  }
+  strcpy(Addr.sun_path, ClServerSocket.c_str());
+
+  int ListenFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (ListenFD < 0) {
+    error(std::error_code(errno, std::generic_category()));
+    return 1;
+  }
+  // Replace the socket left behind by a previous server.
+  ::unlink(Addr.sun_path);
+  if (::bind(ListenFD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) ||
+      ::listen(ListenFD, SOMAXCONN)) {
+    errs() << "LLVMSymbolizer: cannot listen on " << ClServerSocket << ": "
+           << std::error_code(errno, std::generic_category()).message()
+           << "\n";
+    ::close(ListenFD);
+    return 1;
+  }
+
+  // A client that disconnects before reading its answers must only end its
+  // own connection, so writes to a closed socket report EPIPE instead of
+  // raising SIGPIPE.
+  ::signal(SIGPIPE, SIG_IGN);
+
+  // Clients are served concurrently, but all of them share the modules
+  // cached by a single symbolizer, which handles one batch at a time.
+  std::mutex SymbolizerLock;
+  ThreadPool Pool(ClServerThreads
+                      ? ClServerThreads
+                      : std::max(std::thread::hardware_concurrency(), 1u));
+  while (true) {
+    int FD = ::accept(ListenFD, nullptr, nullptr);
+    if (FD < 0) {
+      if (errno == EINTR)
+        continue;
+      error(std::error_code(errno, std::generic_category()));
+      break;
+    }
+    Pool.async([FD, &Symbolizer, &SymbolizerLock] {
+      serveClient(FD, Symbolizer, SymbolizerLock);
+    });
+  }
+  ::close(ListenFD);
+  return 1;
+}
+#else
+static int runServer(LLVMSymbolizer &Symbolizer) {
+  errs() << "LLVMSymbolizer: server mode is not supported on this host\n";
+  return 1;
+}
+#endif
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -156,35 +334,18 @@ int main(int argc, char **argv) {
                 "\" (must have the '.dSYM' extension).\n";
     }
   }
+  Opts.MaxCacheSize = ClMaxCacheSize;
+  Opts.ThreadCount = ClDwarfThreads;
   LLVMSymbolizer Symbolizer(Opts);
 
-  bool IsData = false;
-  std::string ModuleName;
-  uint64_t ModuleOffset;
-  DIPrinter Printer(outs(), ClPrintFunctions != FunctionNameKind::None,
-                    ClPrettyPrint);
+  if (!ClServerSocket.empty())
+    return runServer(Symbolizer);
 
-  while (parseCommand(IsData, ModuleName, ModuleOffset)) {
-    if (ClPrintAddress) {
-      outs() << "0x";
-      outs().write_hex(ModuleOffset);
-      StringRef Delimiter = (ClPrettyPrint == true) ? ": " : "\n";
-      outs() << Delimiter;
-    }
-    if (IsData) {
-      auto ResOrErr = Symbolizer.symbolizeData(ModuleName, ModuleOffset);
-      Printer << (error(ResOrErr.getError()) ? DIGlobal() : ResOrErr.get());
-    } else if (ClPrintInlining) {
-      auto ResOrErr = Symbolizer.symbolizeInlinedCode(ModuleName, ModuleOffset);
-      Printer << (error(ResOrErr.getError()) ? DIInliningInfo()
-                                             : ResOrErr.get());
-    } else {
-      auto ResOrErr = Symbolizer.symbolizeCode(ModuleName, ModuleOffset);
-      Printer << (error(ResOrErr.getError()) ? DILineInfo() : ResOrErr.get());
-    }
-    outs() << "\n";
+  const int kMaxInputStringLength = 1024;
+  char InputString[kMaxInputStringLength];
+  while (fgets(InputString, sizeof(InputString), stdin) &&
+         symbolizeInput(InputString, Symbolizer, outs()))
     outs().flush();
-  }
 
   return 0;
 }
@@ -0,0 +1,73 @@
+//===- llvm/unittest/ADT/StatisticTest.cpp - Statistic unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "unittest"
+STATISTIC(Counter, "Counts things");
+STATISTIC(Quoted, "Counts \"quoted\" things");
+
+namespace {
+
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+TEST(StatisticTest, Count) {
+  unsigned Start = Counter;
+  ++Counter;
+  Counter += 2;
+  EXPECT_EQ(Start + 3, Counter);
+  EXPECT_EQ(Start + 3, Counter++);
+  --Counter;
+  EXPECT_EQ(Start + 3, Counter);
+
+#if LLVM_ENABLE_THREADS
+  // Concurrent updates are not lost.
+  unsigned Before = Counter;
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T != 4; ++T)
+    Threads.emplace_back([] {
+      for (unsigned I = 0; I != 10000; ++I)
+        ++Counter;
+    });
+  for (std::thread &T : Threads)
+    T.join();
+  EXPECT_EQ(Before + 40000, Counter);
+#endif
+}
+
+TEST(StatisticTest, PrintJSON) {
+  // Only statistics first bumped while statistics are enabled are printed.
+  // Leave them disabled for the other tests, which would otherwise print
+  // every statistic they bump on exit.
+  bool WereEnabled = AreStatisticsEnabled();
+  EnableStatistics();
+  Quoted = 7;
+  if (!WereEnabled)
+    DisableStatistics();
+
+  std::string JSON;
+  raw_string_ostream OS(JSON);
+  PrintStatisticsJSON(OS);
+  OS.str();
+
+  EXPECT_EQ('[', JSON.front());
+  EXPECT_NE(std::string::npos,
+            JSON.find("{\"type\": \"unittest\", "
+                      "\"desc\": \"Counts \\\"quoted\\\" things\", "
+                      "\"value\": 7}"));
+}
+#endif
+
+} // end anonymous namespace
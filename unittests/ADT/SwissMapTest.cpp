@@ -0,0 +1,136 @@
+//===- llvm/unittest/ADT/SwissMapTest.cpp - SwissMap unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SwissMap.h"
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+TEST(SwissMapTest, EmptyMap) {
+  SwissMap<int, int> M;
+  EXPECT_TRUE(M.empty());
+  EXPECT_EQ(0u, M.size());
+  EXPECT_TRUE(M.begin() == M.end());
+  EXPECT_EQ(0u, M.count(1));
+  EXPECT_TRUE(M.find(1) == M.end());
+  EXPECT_EQ(0, M.lookup(1));
+  EXPECT_FALSE(M.erase(1));
+  M.clear();
+  EXPECT_TRUE(M.empty());
+}
+
+TEST(SwissMapTest, InsertFindErase) {
+  SwissMap<int, int> M;
+  EXPECT_TRUE(M.insert(std::make_pair(1, 10)).second);
+  EXPECT_FALSE(M.insert(std::make_pair(1, 20)).second);
+  EXPECT_EQ(10, M.lookup(1));
+  EXPECT_EQ(1u, M.size());
+
+  M[2] = 30;
+  EXPECT_EQ(30, M.find(2)->second);
+  EXPECT_EQ(2u, M.size());
+
+  EXPECT_TRUE(M.erase(1));
+  EXPECT_FALSE(M.erase(1));
+  EXPECT_EQ(0u, M.count(1));
+  EXPECT_EQ(1u, M.size());
+
+  M.erase(M.find(2));
+  EXPECT_TRUE(M.empty());
+}
+
+// Keys that all hash to the same value exercise probing across groups and
+// deleted buckets.
+struct CollidingInfo {
+  static unsigned getHashValue(int) { return 0; }
+  static bool isEqual(int LHS, int RHS) { return LHS == RHS; }
+};
+
+TEST(SwissMapTest, Collisions) {
+  SwissMap<int, int, CollidingInfo> M;
+  for (int I = 0; I != 100; ++I)
+    M[I] = I;
+  for (int I = 0; I < 100; I += 2)
+    EXPECT_TRUE(M.erase(I));
+  for (int I = 0; I != 100; ++I)
+    EXPECT_EQ(unsigned(I % 2), M.count(I));
+  for (int I = 0; I < 100; I += 2)
+    M[I] = I;
+  EXPECT_EQ(100u, M.size());
+  for (int I = 0; I != 100; ++I)
+    EXPECT_EQ(I, M.lookup(I));
+}
+
+// Compare a long random sequence of operations against std::map.
+TEST(SwissMapTest, MatchesStdMap) {
+  SwissMap<unsigned, unsigned> M;
+  std::map<unsigned, unsigned> Ref;
+  uint64_t Seed = 1;
+  for (unsigned Step = 0; Step != 200000; ++Step) {
+    Seed = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    unsigned Key = (Seed >> 33) % 5000;
+    switch ((Seed >> 20) % 3) {
+    case 0:
+      M[Key] = Step;
+      Ref[Key] = Step;
+      break;
+    case 1:
+      EXPECT_EQ(Ref.erase(Key) != 0, M.erase(Key));
+      break;
+    case 2:
+      EXPECT_EQ(Ref.count(Key), M.count(Key));
+      break;
+    }
+  }
+  EXPECT_EQ(Ref.size(), M.size());
+  unsigned Visited = 0;
+  for (const auto &KV : M) {
+    EXPECT_EQ(Ref[KV.first], KV.second);
+    ++Visited;
+  }
+  EXPECT_EQ(Ref.size(), Visited);
+}
+
+TEST(SwissMapTest, CopyMoveAndReserve) {
+  SwissMap<int, std::string> M(100);
+  for (int I = 0; I != 100; ++I)
+    M[I] = std::to_string(I);
+
+  SwissMap<int, std::string> Copy(M);
+  EXPECT_EQ(100u, Copy.size());
+  EXPECT_EQ("42", Copy.lookup(42));
+
+  SwissMap<int, std::string> Moved(std::move(M));
+  EXPECT_EQ(100u, Moved.size());
+  EXPECT_EQ("99", Moved.lookup(99));
+
+  Copy = Moved;
+  Copy.erase(5);
+  EXPECT_EQ(99u, Copy.size());
+  EXPECT_EQ(100u, Moved.size());
+
+  Copy.clear();
+  EXPECT_TRUE(Copy.empty());
+  EXPECT_TRUE(Copy.begin() == Copy.end());
+}
+
+TEST(SwissMapTest, MoveOnlyValues) {
+  SwissMap<int, std::unique_ptr<int>> M;
+  for (int I = 0; I != 1000; ++I)
+    M[I].reset(new int(I));
+  for (int I = 0; I != 1000; ++I)
+    EXPECT_EQ(I, *M.find(I)->second);
+}
+
+} // end anonymous namespace
@@ -18,9 +18,13 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/DataStream.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/StreamingMemoryObject.h"
 #include "gtest/gtest.h"
@@ -310,4 +314,65 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+// Write Contents to a new temporary file, returning its path in Path.
+static void writeTemporaryFile(StringRef Suffix, StringRef Contents,
+                               SmallVectorImpl<char> &Path) {
+  int FD;
+  ASSERT_FALSE(
+      sys::fs::createTemporaryFile("BitReaderTest", Suffix, FD, Path));
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  OS << Contents;
+}
+
+TEST(BitReaderTest, LazyIRFileModuleDefersMetadata) {
+  SmallString<1024> Mem;
+  writeModuleToBuffer(parseAssembly("define void @f() {\n"
+                                    "  ret void\n"
+                                    "}\n"
+                                    "!n = !{!0}\n"
+                                    "!0 = !{!\"md\"}\n"),
+                      Mem);
+  SmallString<128> Path;
+  writeTemporaryFile("bc", Mem, Path);
+  FileRemover Cleanup(Path);
+
+  LLVMContext Context;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = getLazyIRFileModule(
+      Path, Err, Context, /*ShouldLazyLoadMetadata=*/true);
+  ASSERT_TRUE(M.get());
+  EXPECT_TRUE(M->getFunction("f")->isMaterializable());
+  EXPECT_FALSE(M->getNamedMetadata("n"));
+
+  EXPECT_FALSE(M->materializeMetadata());
+  ASSERT_TRUE(M->getNamedMetadata("n"));
+  EXPECT_EQ(1u, M->getNamedMetadata("n")->getNumOperands());
+  EXPECT_FALSE(M->materializeAll());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
+TEST(BitReaderTest, LazyIRFileModuleParsesAssembly) {
+  // Files above the mmap threshold whose size is a multiple of the page size
+  // are mapped without a null terminator, which the assembly lexer needs.
+  std::string Assembly = "define i32 @f() {\n"
+                         "  ret i32 42\n"
+                         "}\n";
+  size_t Size = 4 * sys::Process::getPageSize();
+  Assembly += ";";
+  Assembly.append(Size - Assembly.size() - 1, ' ');
+  Assembly += "\n";
+  ASSERT_EQ(Size, Assembly.size());
+  SmallString<128> Path;
+  writeTemporaryFile("ll", Assembly, Path);
+  FileRemover Cleanup(Path);
+
+  LLVMContext Context;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = getLazyIRFileModule(Path, Err, Context);
+  ASSERT_TRUE(M.get());
+  ASSERT_TRUE(M->getFunction("f"));
+  EXPECT_FALSE(M->getFunction("f")->empty());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
 } // end namespace
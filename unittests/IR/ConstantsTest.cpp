@@ -320,6 +320,35 @@ TEST(ConstantsTest, ConstantArrayReplaceWithConstant) {
   ASSERT_EQ(A01, RefArray->getInitializer());
 }
 
+TEST(ConstantsTest, ConstantStructReplaceRepeatedOperand) {
+  LLVMContext Context;
+  std::unique_ptr<Module> M(new Module("MyModule", Context));
+
+  Type *IntTy = Type::getInt8Ty(Context);
+  PointerType *PtrTy = PointerType::getUnqual(IntTy);
+  StructType *STy = StructType::get(PtrTy, IntTy, PtrTy, nullptr);
+  Constant *G1 = new GlobalVariable(*M, IntTy, false,
+                                    GlobalValue::ExternalLinkage, nullptr);
+  Constant *G2 = new GlobalVariable(*M, IntTy, false,
+                                    GlobalValue::ExternalLinkage, nullptr);
+  Constant *One = ConstantInt::get(IntTy, 1);
+
+  Constant *S1Vals[3] = {G1, One, G1};
+  Constant *S1 = ConstantStruct::get(STy, S1Vals);
+  GlobalVariable *Ref =
+      new GlobalVariable(*M, STy, false, GlobalValue::ExternalLinkage, S1);
+
+  // Both uses of G1 are updated, and the result is still uniqued.
+  G1->replaceAllUsesWith(G2);
+  Constant *S2Vals[3] = {G2, One, G2};
+  ASSERT_EQ(ConstantStruct::get(STy, S2Vals), Ref->getInitializer());
+
+  Constant *ZeroVals[3] = {G2, ConstantInt::get(IntTy, 0), G2};
+  Ref->setInitializer(ConstantStruct::get(STy, ZeroVals));
+  G2->replaceAllUsesWith(ConstantPointerNull::get(PtrTy));
+  ASSERT_EQ(ConstantAggregateZero::get(STy), Ref->getInitializer());
+}
+
 TEST(ConstantsTest, ConstantExprReplaceWithConstant) {
   LLVMContext Context;
   std::unique_ptr<Module> M(new Module("MyModule", Context));
@@ -0,0 +1,56 @@
+//===- llvm/unittest/IR/FunctionTest.cpp - Function unit tests ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueSymbolTable.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+TEST(FunctionTest, DeleteBody) {
+  LLVMContext Context;
+  Module M("M", Context);
+  Type *Int32Ty = Type::getInt32Ty(Context);
+  FunctionType *FTy = FunctionType::get(Int32Ty, Int32Ty, false);
+  Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage, "f", &M);
+  Argument *A = &*F->arg_begin();
+  A->setName("a");
+  BasicBlock *Entry = BasicBlock::Create(Context, "entry", F);
+  BasicBlock *Exit = BasicBlock::Create(Context, "exit", F);
+  IRBuilder<> Builder(Entry);
+  Value *Sum = Builder.CreateAdd(A, A, "sum");
+  Builder.CreateBr(Exit);
+  Builder.SetInsertPoint(Exit);
+  Builder.CreateRet(Builder.CreateMul(Sum, A, "prod"));
+
+  // A block whose address is taken outside of the function.
+  GlobalVariable *Ref = new GlobalVariable(
+      M, Type::getInt8PtrTy(Context), false, GlobalValue::ExternalLinkage,
+      BlockAddress::get(F, Exit));
+
+  F->deleteBody();
+  EXPECT_TRUE(F->empty());
+  EXPECT_TRUE(F->isDeclaration());
+  // Only the argument names are left in the symbol table.
+  EXPECT_EQ(1u, F->getValueSymbolTable().size());
+  EXPECT_TRUE(F->getValueSymbolTable().lookup("a"));
+  EXPECT_FALSE(isa<BlockAddress>(Ref->getInitializer()));
+
+  // The function can be given a new body.
+  Builder.SetInsertPoint(BasicBlock::Create(Context, "entry", F));
+  Builder.CreateRet(A);
+  EXPECT_EQ(1u, F->size());
+}
+
+} // end anonymous namespace
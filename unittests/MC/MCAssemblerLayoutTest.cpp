@@ -0,0 +1,127 @@
+//===- llvm/unittest/MC/MCAssemblerLayoutTest.cpp -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Checks that MCAssembler relaxation reaches the expected fixed point on a
+// section in which every relaxable fragment only needs relaxing once the one
+// before it has been relaxed.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCCodeEmitter.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCParser/MCAsmParser.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCTargetAsmParser.h"
+#include "llvm/MC/MCTargetOptions.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+const char *TripleName = "x86_64-unknown-linux-gnu";
+
+class MCAssemblerLayoutTest : public testing::Test {
+protected:
+  void SetUp() override {
+    InitializeAllTargetInfos();
+    InitializeAllTargetMCs();
+    InitializeAllAsmParsers();
+
+    std::string Error;
+    TheTarget = TargetRegistry::lookupTarget(TripleName, Error);
+    if (!TheTarget)
+      return;
+    MRI.reset(TheTarget->createMCRegInfo(TripleName));
+    MAI.reset(TheTarget->createMCAsmInfo(*MRI, TripleName));
+    MII.reset(TheTarget->createMCInstrInfo());
+    STI.reset(TheTarget->createMCSubtargetInfo(TripleName, "", ""));
+  }
+
+  // Assemble Source into an ELF object, returning the size of its .text
+  // section.
+  uint64_t assemble(const std::string &Source) {
+    SourceMgr SrcMgr;
+    SrcMgr.AddNewSourceBuffer(MemoryBuffer::getMemBuffer(Source), SMLoc());
+
+    Triple TheTriple(TripleName);
+    MCObjectFileInfo MOFI;
+    MCContext Ctx(MAI.get(), MRI.get(), &MOFI, &SrcMgr);
+    MOFI.InitMCObjectFileInfo(TheTriple, Reloc::Default, CodeModel::Default,
+                              Ctx);
+
+    SmallString<0> Object;
+    raw_svector_ostream OS(Object);
+    MCCodeEmitter *CE = TheTarget->createMCCodeEmitter(*MII, *MRI, Ctx);
+    MCAsmBackend *MAB = TheTarget->createMCAsmBackend(*MRI, TripleName, "");
+    std::unique_ptr<MCStreamer> Str(TheTarget->createMCObjectStreamer(
+        TheTriple, Ctx, *MAB, OS, CE, *STI, /*RelaxAll=*/false,
+        /*DWARFMustBeAtTheEnd=*/false));
+
+    MCTargetOptions MCOptions;
+    std::unique_ptr<MCAsmParser> Parser(
+        createMCAsmParser(SrcMgr, Ctx, *Str, *MAI));
+    std::unique_ptr<MCTargetAsmParser> TAP(
+        TheTarget->createMCAsmParser(*STI, *Parser, *MII, MCOptions));
+    Parser->setTargetParser(*TAP);
+
+    EXPECT_FALSE(Parser->Run(/*NoInitialTextSection=*/false));
+
+    auto ObjOrErr = object::ObjectFile::createObjectFile(
+        MemoryBufferRef(Object.str(), "layout-test"));
+    EXPECT_TRUE(bool(ObjOrErr));
+    if (!ObjOrErr)
+      return 0;
+    for (const object::SectionRef &Sec : (*ObjOrErr)->sections()) {
+      StringRef Name;
+      if (!Sec.getName(Name) && Name == ".text")
+        return Sec.getSize();
+    }
+    ADD_FAILURE() << "no .text section in the object";
+    return 0;
+  }
+
+  const Target *TheTarget = nullptr;
+  std::unique_ptr<MCRegisterInfo> MRI;
+  std::unique_ptr<MCAsmInfo> MAI;
+  std::unique_ptr<MCInstrInfo> MII;
+  std::unique_ptr<MCSubtargetInfo> STI;
+};
+
+TEST_F(MCAssemblerLayoutTest, RelaxationChain) {
+  if (!TheTarget)
+    return;
+
+  // The first two jumps are too far from .Lfar for their short form. Each of
+  // the other two jumps back over exactly 128 bytes while the blocks it
+  // crosses hold short jumps, so it only needs relaxing once the jump two
+  // blocks before it has been relaxed.
+  const char *Source = "\t.text\n"
+                       ".Lfar:\n\t.fill 200, 1, 0x90\n"
+                       ".Lb0:\n\tjmp .Lfar\n\t.fill 61, 1, 0x90\n"
+                       ".Lb1:\n\tjmp .Lfar\n\t.fill 61, 1, 0x90\n"
+                       ".Lb2:\n\tjmp .Lb0\n\t.fill 61, 1, 0x90\n"
+                       ".Lb3:\n\tjmp .Lb1\n\t.fill 61, 1, 0x90\n";
+  // Every jump ends up in its 5 byte near form.
+  EXPECT_EQ(200u + 4 * (5 + 61), assemble(Source));
+}
+
+} // end anonymous namespace
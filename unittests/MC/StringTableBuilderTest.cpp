@@ -11,6 +11,7 @@
 #include "llvm/Support/Endian.h"
 #include "gtest/gtest.h"
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -68,4 +69,53 @@ TEST(StringTableBuilderTest, BasicWinCOFF) {
   EXPECT_EQ(23U, B.getOffset("river horse"));
 }
 
+TEST(StringTableBuilderTest, CachedHash) {
+  StringTableBuilder B(StringTableBuilder::ELF);
+
+  CachedHashStringRef Foo("foo");
+  CachedHashStringRef FooBar("foobar");
+  B.add(Foo);
+  B.add(FooBar);
+  B.add("bar");
+
+  B.finalize();
+
+  EXPECT_EQ(1U, B.getOffset(FooBar));
+  EXPECT_EQ(B.getOffset(FooBar), B.getOffset("foobar"));
+  EXPECT_EQ(8U, B.getOffset(Foo));
+  EXPECT_EQ(4U, B.getOffset(CachedHashStringRef("bar")));
+}
+
+TEST(StringTableBuilderTest, LargeELF) {
+  // Enough strings to sort them in parallel.
+  const unsigned NumStrings = 1 << 17;
+  std::vector<std::string> Strings;
+  for (unsigned I = 0; I != NumStrings; ++I) {
+    Strings.push_back("sym" + std::to_string(I));
+    Strings.push_back("_sym" + std::to_string(I));
+  }
+
+  StringTableBuilder B(StringTableBuilder::ELF);
+  StringTableBuilder Serial(StringTableBuilder::ELF);
+  for (const std::string &S : Strings) {
+    B.add(S);
+    Serial.add(S);
+  }
+  B.finalize(4);
+  Serial.finalize();
+  EXPECT_EQ(Serial.data(), B.data());
+
+  // Every "symN" is merged into the tail of "_symN".
+  size_t ExpectedSize = 1;
+  for (unsigned I = 0; I != NumStrings; ++I)
+    ExpectedSize += Strings[2 * I + 1].size() + 1;
+  EXPECT_EQ(ExpectedSize, B.data().size());
+
+  for (unsigned I = 0; I != NumStrings; ++I) {
+    size_t Offset = B.getOffset(Strings[2 * I]);
+    EXPECT_EQ(B.getOffset(Strings[2 * I + 1]) + 1, Offset);
+    EXPECT_EQ(Strings[2 * I], B.data().substr(Offset).data());
+  }
+}
+
 }
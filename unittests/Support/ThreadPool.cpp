@@ -0,0 +1,123 @@
+//========- unittests/Support/ThreadPool.cpp - ThreadPool.h tests --========//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// Fixture for the unittests, allowing to *temporarily* wait on a thread: the
+// main thread can block on MainThreadReady() and the tasks submitted to the
+// pool can be released with setMainThreadReady().
+class ThreadPoolTest : public testing::Test {
+protected:
+  void SetUp() override { MainThreadReady = false; }
+
+  /// Blocking until the main thread has called setMainThreadReady().
+  void waitForMainThread() {
+    std::unique_lock<std::mutex> LockGuard(WaitMainThreadLock);
+    WaitMainThread.wait(LockGuard, [&] { return MainThreadReady; });
+  }
+
+  /// Allow the tasks waiting in waitForMainThread() to proceed.
+  void setMainThreadReady() {
+    {
+      std::unique_lock<std::mutex> LockGuard(WaitMainThreadLock);
+      MainThreadReady = true;
+    }
+    WaitMainThread.notify_all();
+  }
+
+  std::condition_variable WaitMainThread;
+  std::mutex WaitMainThreadLock;
+  bool MainThreadReady;
+};
+
+TEST_F(ThreadPoolTest, AsyncBarrier) {
+  // test that async & barrier work together properly.
+
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool;
+  for (size_t i = 0; i < 5; ++i) {
+    Pool.async([this, &checked_in, i] {
+      waitForMainThread();
+      ++checked_in;
+    });
+  }
+  ASSERT_EQ(0, checked_in);
+  setMainThreadReady();
+  Pool.wait();
+  ASSERT_EQ(5, checked_in);
+}
+
+static void TestFunc(std::atomic_int &checked_in, int i) { checked_in += i; }
+
+TEST_F(ThreadPoolTest, AsyncBarrierArgs) {
+  // Test that async works with a function requiring multiple parameters.
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool;
+  for (size_t i = 0; i < 5; ++i) {
+    Pool.async(TestFunc, std::ref(checked_in), i);
+  }
+  Pool.wait();
+  ASSERT_EQ(10, checked_in);
+}
+
+TEST_F(ThreadPoolTest, Async) {
+  ThreadPool Pool;
+  std::atomic_int i{0};
+  Pool.async([this, &i] {
+    waitForMainThread();
+    ++i;
+  });
+  Pool.async([&i] { ++i; });
+  ASSERT_NE(2, i.load());
+  setMainThreadReady();
+  Pool.wait();
+  ASSERT_EQ(2, i.load());
+}
+
+TEST_F(ThreadPoolTest, GetFuture) {
+  ThreadPool Pool{2};
+  std::atomic_int i{0};
+  Pool.async([this, &i] {
+    waitForMainThread();
+    ++i;
+  });
+  // Force the future using get()
+  Pool.async([&i] { ++i; }).get();
+  ASSERT_NE(2, i.load());
+  setMainThreadReady();
+  Pool.wait();
+  ASSERT_EQ(2, i.load());
+}
+
+TEST_F(ThreadPoolTest, PoolDestruction) {
+  // Test that we are waiting on destruction
+  std::atomic_int checked_in{0};
+  {
+    ThreadPool Pool;
+    for (size_t i = 0; i < 5; ++i) {
+      Pool.async([this, &checked_in, i] {
+        waitForMainThread();
+        ++checked_in;
+      });
+    }
+    ASSERT_EQ(0, checked_in);
+    setMainThreadReady();
+  }
+  ASSERT_EQ(5, checked_in);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,62 @@
+//===- unittests/Support/TimerTest.cpp - Timer tests ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(Timer, ConcurrentStartStop) {
+  TimerGroup TG("ConcurrentStartStop");
+  Timer T1("T1", TG), T2("T2", TG);
+
+  // Start and stop the same timers from several threads, interleaving them so
+  // that the bookkeeping of the active timers is exercised concurrently.
+  double Start = TimeRecord::getCurrentTime(true).getWallTime();
+  ThreadPool Pool(4);
+  for (unsigned I = 0; I != 64; ++I) {
+    Pool.async([&T1, &T2, I] {
+      Timer &Outer = (I & 1) ? T1 : T2;
+      Timer &Inner = (I & 1) ? T2 : T1;
+      TimeRegion OuterRegion(Outer);
+      TimeRegion InnerRegion(Inner);
+    });
+  }
+  Pool.wait();
+  double Elapsed = TimeRecord::getCurrentTime(false).getWallTime() - Start;
+
+  // Every region was stopped, and none of the updates of the timers was lost:
+  // a lost start or stop would leave a timer with the absolute time of day
+  // rather than at most the time of the four threads running regions.
+  for (Timer *T : {&T1, &T2}) {
+    EXPECT_FALSE(T->isRunning());
+    EXPECT_TRUE(T->hasTriggered());
+    EXPECT_LT(0.0, T->getTotalTime().getWallTime());
+    EXPECT_GE(4 * Elapsed, T->getTotalTime().getWallTime());
+  }
+
+  // Printing the group reports and resets both timers, so nothing is left to
+  // be printed when the group is destroyed.
+  std::string Report;
+  raw_string_ostream OS(Report);
+  TG.print(OS);
+  OS.flush();
+  EXPECT_NE(std::string::npos, Report.find("T1"));
+  EXPECT_NE(std::string::npos, Report.find("T2"));
+  for (Timer *T : {&T1, &T2}) {
+    EXPECT_FALSE(T->hasTriggered());
+    EXPECT_EQ(0.0, T->getTotalTime().getWallTime());
+  }
+}
+
+} // end anonymous namespace
@@ -0,0 +1,308 @@
+//===- LLVMBench - Benchmark LLVM data structures and components ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program times operations whose speed matters to the compiler, but which
+// the unit tests only check for correctness. Each benchmark reports its times
+// through a timer group of its own.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SwissMap.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCCodeEmitter.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCParser/MCAsmParser.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCTargetAsmParser.h"
+#include "llvm/MC/MCTargetOptions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string>
+    BenchmarkNames(cl::Positional, cl::ZeroOrMore,
+                   cl::desc("<benchmarks to run, all if none is given>"));
+
+static cl::opt<bool> List("list", cl::desc("List the available benchmarks"));
+
+namespace {
+/// The timers of one benchmark, which are reported together once it is done.
+class BenchmarkTimers {
+  TimerGroup Group;
+  std::vector<std::unique_ptr<Timer>> Timers;
+
+public:
+  explicit BenchmarkTimers(StringRef Name) : Group(Name) {}
+
+  /// Add a timer named Name, which accumulates the time of every region it
+  /// is started for.
+  Timer &add(const Twine &Name) {
+    Timers.emplace_back(new Timer(Name.str(), Group));
+    return *Timers.back();
+  }
+
+  /// Time Fn with a new timer named Name.
+  void time(const Twine &Name, function_ref<void()> Fn) {
+    TimeRegion Region(add(Name));
+    Fn();
+  }
+};
+}
+
+//===----------------------------------------------------------------------===//
+// Hash maps
+//===----------------------------------------------------------------------===//
+
+template <typename MapT>
+static void benchmarkMap(BenchmarkTimers &Timers, StringRef Name,
+                         const std::vector<int *> &Keys,
+                         const std::vector<int *> &Missing) {
+  MapT M;
+  unsigned Found = 0;
+  Timers.time(Name + ": insert", [&] {
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      M[Keys[I]] = I;
+  });
+  Timers.time(Name + ": hit", [&] {
+    for (int *K : Keys)
+      Found += M.count(K);
+  });
+  Timers.time(Name + ": miss", [&] {
+    for (int *K : Missing)
+      Found += M.count(K);
+  });
+  Timers.time(Name + ": erase", [&] {
+    for (int *K : Keys)
+      M.erase(K);
+  });
+  if (Found != Keys.size() || !M.empty())
+    report_fatal_error(Name + " lost track of its keys");
+}
+
+// Compare DenseMap and SwissMap on pointer keys, which are the most common
+// kind of key in the compiler.
+static void benchmarkMaps() {
+  // Space the keys like heap allocated objects of 32 bytes.
+  const unsigned N = 1 << 18, Spacing = 8;
+  std::vector<int> Storage(2 * N * Spacing);
+  std::vector<int *> Keys, Missing;
+  for (unsigned I = 0; I != N; ++I) {
+    Keys.push_back(&Storage[2 * I * Spacing]);
+    Missing.push_back(&Storage[(2 * I + 1) * Spacing]);
+  }
+  // Don't let the insertion order match the address order.
+  uint64_t Seed = 1;
+  for (unsigned I = N - 1; I > 0; --I) {
+    Seed = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    std::swap(Keys[I], Keys[(Seed >> 33) % (I + 1)]);
+  }
+
+  BenchmarkTimers Timers("Hash map benchmark");
+  benchmarkMap<DenseMap<int *, unsigned>>(Timers, "DenseMap", Keys, Missing);
+  benchmarkMap<SwissMap<int *, unsigned>>(Timers, "SwissMap", Keys, Missing);
+}
+
+//===----------------------------------------------------------------------===//
+// IR churn
+//===----------------------------------------------------------------------===//
+
+// Fill F with NumBlocks blocks of NumInstrs additions each, chained through
+// all blocks so that every block uses values from the one above it.
+static void buildBody(Function &F, unsigned NumBlocks, unsigned NumInstrs,
+                      bool Named) {
+  auto AI = F.arg_begin();
+  Value *V = &*AI++;
+  Value *Step = &*AI;
+  BasicBlock *BB = BasicBlock::Create(F.getContext(), "entry", &F);
+  IRBuilder<> Builder(BB);
+  for (unsigned B = 0; B != NumBlocks; ++B) {
+    for (unsigned I = 0; I != NumInstrs; ++I)
+      V = Builder.CreateAdd(V, Step, Named ? "v" : "");
+    BB = BasicBlock::Create(F.getContext(), "bb", &F);
+    Builder.CreateBr(BB);
+    Builder.SetInsertPoint(BB);
+  }
+  Builder.CreateRet(V);
+}
+
+// Build and delete many short-lived functions, the pattern of JIT clients,
+// with and without value names.
+static void benchmarkFunctionChurn() {
+  LLVMContext Context;
+  Module M("M", Context);
+  Type *Int32Ty = Type::getInt32Ty(Context);
+  Type *Params[] = {Int32Ty, Int32Ty};
+  FunctionType *FTy = FunctionType::get(Int32Ty, Params, false);
+
+  BenchmarkTimers Timers("Function churn benchmark");
+  for (bool Named : {false, true}) {
+    StringRef Kind = Named ? "named" : "unnamed";
+    Timer &Build = Timers.add(Kind + " instructions: build");
+    Timer &Delete = Timers.add(Kind + " instructions: delete");
+    for (unsigned Iter = 0; Iter != 200; ++Iter) {
+      Function *F;
+      {
+        TimeRegion Region(Build);
+        F = Function::Create(FTy, GlobalValue::ExternalLinkage, "f", &M);
+        buildBody(*F, 20, 50, Named);
+      }
+      TimeRegion Region(Delete);
+      F->eraseFromParent();
+    }
+  }
+  if (!M.empty())
+    report_fatal_error("functions were left in the module");
+}
+
+//===----------------------------------------------------------------------===//
+// MC relaxation
+//===----------------------------------------------------------------------===//
+
+// Build a chain of NumJumps short backward jumps in which every jump only needs
+// relaxing once the one before it has been relaxed, so that the whole chain
+// has to be relaxed one jump at a time.
+static std::string buildRelaxationChain(unsigned NumJumps) {
+  std::string Source;
+  raw_string_ostream OS(Source);
+  OS << "\t.text\n.Lfar:\n\t.fill 200, 1, 0x90\n";
+  for (unsigned I = 0; I != NumJumps; ++I) {
+    OS << ".Lb" << I << ":\n\tjmp ";
+    if (I < 2)
+      OS << ".Lfar\n";
+    else
+      OS << ".Lb" << I - 2 << "\n";
+    OS << "\t.fill 61, 1, 0x90\n";
+  }
+  return OS.str();
+}
+
+// Assemble relaxation chains of growing length into ELF objects.
+static void benchmarkRelaxation() {
+  const char *TripleName = "x86_64-unknown-linux-gnu";
+  std::string Error;
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleName, Error);
+  if (!TheTarget) {
+    errs() << "skipping the MC relaxation benchmark: " << Error << "\n";
+    return;
+  }
+  std::unique_ptr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
+  std::unique_ptr<MCAsmInfo> MAI(
+      TheTarget->createMCAsmInfo(*MRI, TripleName));
+  std::unique_ptr<MCInstrInfo> MII(TheTarget->createMCInstrInfo());
+  std::unique_ptr<MCSubtargetInfo> STI(
+      TheTarget->createMCSubtargetInfo(TripleName, "", ""));
+  Triple TheTriple(TripleName);
+
+  BenchmarkTimers Timers("MC relaxation benchmark");
+  for (unsigned NumJumps = 500; NumJumps <= 8000; NumJumps *= 2) {
+    SourceMgr SrcMgr;
+    SrcMgr.AddNewSourceBuffer(
+        MemoryBuffer::getMemBufferCopy(buildRelaxationChain(NumJumps)),
+        SMLoc());
+    MCObjectFileInfo MOFI;
+    MCContext Ctx(MAI.get(), MRI.get(), &MOFI, &SrcMgr);
+    MOFI.InitMCObjectFileInfo(TheTriple, Reloc::Default, CodeModel::Default,
+                              Ctx);
+
+    SmallString<0> Object;
+    raw_svector_ostream OS(Object);
+    MCCodeEmitter *CE = TheTarget->createMCCodeEmitter(*MII, *MRI, Ctx);
+    MCAsmBackend *MAB = TheTarget->createMCAsmBackend(*MRI, TripleName, "");
+    std::unique_ptr<MCStreamer> Str(TheTarget->createMCObjectStreamer(
+        TheTriple, Ctx, *MAB, OS, CE, *STI, /*RelaxAll=*/false,
+        /*DWARFMustBeAtTheEnd=*/false));
+
+    MCTargetOptions MCOptions;
+    std::unique_ptr<MCAsmParser> Parser(
+        createMCAsmParser(SrcMgr, Ctx, *Str, *MAI));
+    std::unique_ptr<MCTargetAsmParser> TAP(
+        TheTarget->createMCAsmParser(*STI, *Parser, *MII, MCOptions));
+    Parser->setTargetParser(*TAP);
+
+    bool Failed = false;
+    Timers.time(Twine(NumJumps) + " relaxable fragments", [&] {
+      Failed = Parser->Run(/*NoInitialTextSection=*/false);
+    });
+    if (Failed)
+      report_fatal_error("cannot assemble the relaxation chain");
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Driver
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct Benchmark {
+  const char *Name;
+  const char *Desc;
+  void (*Run)();
+};
+}
+
+static const Benchmark Benchmarks[] = {
+    {"maps", "DenseMap and SwissMap on pointer keys", benchmarkMaps},
+    {"function-churn", "Building and deleting short-lived functions",
+     benchmarkFunctionChurn},
+    {"mc-relaxation", "Assembling sections that need many relaxation passes",
+     benchmarkRelaxation},
+};
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y; // Call llvm_shutdown() on exit.
+  InitializeAllTargetInfos();
+  InitializeAllTargetMCs();
+  InitializeAllAsmParsers();
+  cl::ParseCommandLineOptions(argc, argv, "LLVM benchmarks\n");
+
+  if (List) {
+    for (const Benchmark &B : Benchmarks)
+      outs() << B.Name << " - " << B.Desc << "\n";
+    return 0;
+  }
+
+  for (const std::string &Name : BenchmarkNames)
+    if (std::none_of(std::begin(Benchmarks), std::end(Benchmarks),
+                     [&](const Benchmark &B) { return Name == B.Name; })) {
+      errs() << argv[0] << ": unknown benchmark '" << Name << "'\n";
+      return 1;
+    }
+
+  for (const Benchmark &B : Benchmarks)
+    if (BenchmarkNames.empty() ||
+        std::find(BenchmarkNames.begin(), BenchmarkNames.end(), B.Name) !=
+            BenchmarkNames.end())
+      B.Run();
+  return 0;
+}